@@ -21,7 +21,9 @@
 #include "llvm/ExecutionEngine/Orc/LambdaResolver.h"
 #include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
 #include "llvm/IR/Mangler.h"
+#include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 namespace llvm {
 namespace orc {
@@ -59,6 +61,34 @@ public:
     return H;
   }
 
+  // Load object file emitted by SimpleCompiler with the target machine of
+  // this JIT. Its symbols are resolved like those of modules and the handle
+  // is removed by removeModule.
+  bool addObjectFile(const std::string &Path, ModuleHandleT &H) {
+    auto Buffer = MemoryBuffer::getFile(Path);
+    if (!Buffer)
+      return false;
+    auto Obj = object::ObjectFile::createObjectFile((*Buffer)->getMemBufferRef());
+    if (!Obj)
+      return false;
+    std::vector<std::unique_ptr<object::OwningBinary<object::ObjectFile>>>
+        Objects;
+    Objects.push_back(make_unique<object::OwningBinary<object::ObjectFile>>(
+        std::move(*Obj), std::move(*Buffer)));
+    auto Resolver = createLambdaResolver(
+        [&](const std::string &Name) {
+          if (auto Sym = findMangledSymbol(Name))
+            return RuntimeDyld::SymbolInfo(Sym.getAddress(), Sym.getFlags());
+          return RuntimeDyld::SymbolInfo(nullptr);
+        },
+        [](const std::string &S) { return nullptr; });
+    H = ObjectLayer.addObjectSet(std::move(Objects),
+                                 make_unique<SectionMemoryManager>(),
+                                 std::move(Resolver));
+    ModuleHandles.push_back(H);
+    return true;
+  }
+
   void removeModule(ModuleHandleT H) {
     ModuleHandles.erase(
         std::find(ModuleHandles.begin(), ModuleHandles.end(), H));
@@ -0,0 +1,30 @@
+program arrayParam;
+
+var I : integer;
+var X : array [1 .. 10] of integer;
+var Y : array [0 .. 99] of integer;
+
+procedure square(A : array [1 .. 10] of integer);
+var I : integer;
+begin
+    for I := 1 to 10 do
+        A[I] := A[I] * A[I]
+end;
+
+function total(A : array of integer; N : integer) : integer;
+var I : integer;
+begin
+    total := 0;
+    for I := 0 to N - 1 do
+        total := total + A[I]
+end;
+
+begin
+    for I := 1 to 10 do
+        X[I] := I;
+    fill(Y, 2);
+    square(X);
+    writeln(total(X, 10));
+    writeln(total(Y, 100));
+    writeln(sum(Y));
+end.
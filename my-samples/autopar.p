@@ -0,0 +1,22 @@
+program autopar;
+
+var I, J, N, T : integer;
+var X, Y : array [0 .. 20000] of integer;
+begin
+    N := 20000;
+    for I := 0 to N do
+        X[I] := (I * 37) mod 10001;
+
+    for I := 1 to N do begin
+        T := X[I] * 2;
+        for J := 0 to 3 do
+            T := T + J;
+        Y[I] := T
+    end;
+
+    for I := 1 to N do
+        X[I] := X[I - 1] + Y[I];
+
+    writeln(X[N]);
+    writeln(Y[N]);
+end.
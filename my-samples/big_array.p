@@ -0,0 +1,18 @@
+program bigArray;
+
+var I : integer;
+var X : array [1 .. 50000000] of integer;
+
+function tail(N : integer) : integer;
+var Y : array [0 .. 100000] of integer;
+begin
+    fill(Y, N);
+    tail := sum(Y);
+end;
+
+begin
+    for I := 1 to 50000000 do
+        X[I] := I mod 7;
+    writeln(sum(X));
+    writeln(tail(3));
+end.
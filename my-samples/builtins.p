@@ -0,0 +1,15 @@
+program builtins;
+
+var I : integer;
+var X : array [0 .. 20] of integer;
+begin
+    for I := 0 to 20 do
+        X[I] := (I * 37) mod 21;
+
+    writeln(sum(X));
+    writeln(max(X));
+    writeln(min(X));
+    writeln(count(X, 5));
+    prefixsum(X);
+    writeln(X[20]);
+end.
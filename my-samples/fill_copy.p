@@ -0,0 +1,15 @@
+program fillCopy;
+
+var I : integer;
+var X, Y : array [1 .. 10] of integer;
+begin
+    fill(X, 0);
+    fill(Y, 7);
+    for I := 1 to 5 do
+        X[I] := I;
+    copy(X, 6, X, 1, 5);
+    Y := X;
+    copy(Y, 2, Y, 1, 9);
+    for I := 1 to 10 do
+        writeln(Y[I]);
+end.
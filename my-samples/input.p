@@ -0,0 +1,15 @@
+program sumInput;
+
+var X, S, N : integer;
+begin
+    S := 0;
+    N := 0;
+    while not eof do
+    begin
+        readln(X);
+        S := S + X;
+        inc(N)
+    end;
+    writeln(N);
+    writeln(S)
+end.
@@ -0,0 +1,12 @@
+program mapFile;
+
+var X : array [0 .. 999999] of integer;
+    N, I : integer;
+begin
+    N := mapcopy(X, 1);
+    writeln(N);
+    writeln(sum(X));
+    for I := 0 to N - 1 do
+        X[I] := X[I] * 2;
+    writeln(dump(X, 2))
+end.
@@ -0,0 +1,24 @@
+unit mathunit;
+
+const LIMIT = 20;
+
+function gcd(A : integer; B : integer) : integer;
+var T : integer;
+begin
+    while B <> 0 do begin
+        T := B;
+        B := A mod B;
+        A := T
+    end;
+    gcd := A
+end;
+
+procedure swap(var X : integer; var Y : integer);
+var T : integer;
+begin
+    T := X;
+    X := Y;
+    Y := T
+end;
+
+end.
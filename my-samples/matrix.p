@@ -0,0 +1,24 @@
+program matrix;
+
+const N = 4;
+var I, J, K, S : integer;
+var A, B, C : array [1 .. 4, 1 .. 4] of integer;
+begin
+    for I := 1 to N do
+        for J := 1 to N do begin
+            A[I, J] := I + J;
+            B[I][J] := I - J
+        end;
+
+    for I := 1 to N do
+        for J := 1 to N do begin
+            S := 0;
+            for K := 1 to N do
+                S := S + A[I, K] * B[K, J];
+            C[I, J] := S
+        end;
+
+    for I := 1 to N do
+        for J := 1 to N do
+            writeln(C[I, J]);
+end.
@@ -0,0 +1,24 @@
+program narrow;
+
+const N = 100000;
+
+var I : integer;
+var H : array [0 .. 255] of integer;
+var B : array [1 .. N] of byte;
+var S : array [1 .. N] of shortint;
+
+begin
+    for I := 1 to N do
+    begin
+        B[I] := I;
+        S[I] := I
+    end;
+    writeln(B[300]);
+    writeln(S[200]);
+    writeln(sum(B));
+    writeln(min(S));
+    writeln(count(B, 0));
+    for I := 1 to N do
+        inc(H[B[I]]);
+    writeln(H[255]);
+end.
@@ -0,0 +1,27 @@
+program parallelExit;
+
+var I, J, S : integer;
+var X : array [1 .. 1000] of integer;
+
+function firstBig(N : integer) : integer;
+var I : integer;
+begin
+    firstBig := 0;
+    parallel for I := 1 to N do
+        if I * I > N then begin
+            firstBig := I;
+            exit
+        end
+end;
+
+begin
+    S := 0;
+    parallel for I := 1 to 1000 reduce (sum: S) do begin
+        X[I] := I;
+        if I = 500 then
+            break;
+        S := S + I
+    end;
+    writeln(S);
+    writeln(firstBig(1000))
+end.
@@ -0,0 +1,10 @@
+program readArray;
+
+var X : array [1 .. 1000] of integer;
+    N, A, B : integer;
+begin
+    readln(A, B);
+    N := readarray(X, A);
+    writeln(N);
+    writeln(sum(X) * B)
+end.
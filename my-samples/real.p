@@ -0,0 +1,34 @@
+program realNumbers;
+
+const N = 1000000;
+
+var I : integer;
+var X, Y : array [1 .. N] of real;
+var A, Dot : real;
+
+function norm(V : array of real; N : integer) : real;
+var I : integer;
+begin
+    norm := 0.0;
+    for I := 0 to N - 1 do
+        norm := norm + V[I] * V[I]
+end;
+
+begin
+    A := 2.5;
+    for I := 1 to N do
+    begin
+        X[I] := I / N;
+        Y[I] := 1.0
+    end;
+    for I := 1 to N do
+        Y[I] := A * X[I] + Y[I];
+    Dot := 0.0;
+    for I := 1 to N do
+        Dot := Dot + X[I] * Y[I];
+    writeln(Dot);
+    writeln(norm(X, N));
+    writeln(sum(Y));
+    writeln(round(max(Y)));
+    writeln(trunc(-1.5e0));
+end.
@@ -0,0 +1,18 @@
+program parallelReduce;
+
+var I, MAX, SUM : integer;
+var X : array [0 .. 10000] of integer;
+begin
+    for I := 0 to 10000 do
+        X[I] := (I * 37) mod 10001;
+
+    MAX := X[0];
+    SUM := 0;
+    parallel for I := 0 to 10000 reduce (max: MAX) reduce (sum: SUM) do begin
+        if MAX < X[I] then
+            MAX := X[I];
+        SUM := SUM + X[I]
+    end;
+    writeln(MAX);
+    writeln(SUM);
+end.
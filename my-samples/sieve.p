@@ -0,0 +1,29 @@
+program sieve;
+
+const N = 10000000;
+
+var I, J : integer;
+var P : packed array [2 .. N] of boolean;
+var Done : boolean;
+
+begin
+    fill(P, true);
+    I := 2;
+    Done := false;
+    while not Done do
+    begin
+        if P[I] then
+        begin
+            J := I * I;
+            while J <= N do
+            begin
+                P[J] := false;
+                J := J + I
+            end
+        end;
+        I := I + 1;
+        Done := I * I > N
+    end;
+    writeln(count(P, true));
+    writeln(P[9999991]);
+end.
@@ -0,0 +1,26 @@
+program spawnFib;
+
+function fib(n : integer) : integer;
+var a, b : integer;
+begin
+    if n < 2 then
+        fib := n
+    else begin
+        spawn a := fib(n - 1);
+        b := fib(n - 2);
+        sync;
+        fib := a + b
+    end
+end;
+
+procedure show(n : integer);
+begin
+    writeln(fib(n))
+end;
+
+begin
+    spawn show(25);
+    spawn show(30);
+    sync;
+    writeln(fib(32));
+end.
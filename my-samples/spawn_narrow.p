@@ -0,0 +1,31 @@
+program spawnNarrow;
+
+const N = 20;
+
+var I : integer;
+var T : array [1 .. N] of integer;
+var B : array [1 .. N] of byte;
+
+function steps(n : integer) : integer;
+var s : integer;
+begin
+    s := 0;
+    while n <> 1 do begin
+        if n mod 2 = 0 then
+            n := n div 2
+        else
+            n := 3 * n + 1;
+        s := s + 1
+    end;
+    steps := s
+end;
+
+begin
+    for I := 1 to N do
+        spawn T[I] := steps(I + 100);
+    sync;
+    for I := 1 to N do
+        B[I] := T[I];
+    writeln(B);
+    writeln(sum(B))
+end.
@@ -0,0 +1,13 @@
+program useUnit;
+
+uses mathunit;
+
+var A, B : integer;
+begin
+    A := 12;
+    B := 18;
+    writeln(gcd(A, B));
+    swap(A, B);
+    writeln(A, B);
+    writeln(LIMIT)
+end.
@@ -0,0 +1,34 @@
+program varParam;
+
+var A, B, Q, R : integer;
+var X : array [1 .. 2] of integer;
+
+procedure swap(var X : integer; var Y : integer);
+var T : integer;
+begin
+    T := X;
+    X := Y;
+    Y := T
+end;
+
+procedure divmod(N : integer; D : integer; var Q : integer; var R : integer);
+begin
+    Q := N div D;
+    R := N mod D
+end;
+
+begin
+    A := 1;
+    B := 2;
+    swap(A, B);
+    writeln(A);
+    writeln(B);
+    divmod(17, 5, Q, R);
+    writeln(Q);
+    writeln(R);
+    X[1] := 3;
+    X[2] := 4;
+    swap(X[1], X[2]);
+    writeln(X[1]);
+    writeln(X[2]);
+end.
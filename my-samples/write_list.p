@@ -0,0 +1,14 @@
+program writeList;
+
+var X : array [1 .. 10] of integer;
+    B : array [0 .. 3] of byte;
+    I : integer;
+begin
+    for I := 1 to 10 do
+        X[I] := I * I;
+    B[3] := 255;
+    writeln(1, 2.5, 3);
+    writeln(X);
+    write(B, sum(X));
+    writeln(0)
+end.
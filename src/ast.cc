@@ -1,18 +1,32 @@
+#include <algorithm>
+#include <cstddef>
 #include <cstdio>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <cstdlib>
-#include <fstream>
+#include <deque>
+#include <set>
+#include <sstream>
 #include <stdexcept>
+#include <sys/stat.h>
 #include "ast.h"
 #include "parser.h"
+#include "runtime.h"
+#include "server.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Vectorize.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
@@ -23,21 +37,1224 @@ using namespace ast;
 static llvm::LLVMContext context;
 static llvm::IRBuilder<> builder{context};
 static std::unique_ptr<llvm::Module> module;
-static std::map<std::string, llvm::AllocaInst *> named_vals;
-static std::map<std::string, llvm::AllocaInst *> const_vals;
-static std::map<std::string, long int> arr_starts;
+/* open addressing table of symbol numbers by hash, -1 is empty slot */
+static std::vector<int> symbol_slots(1024, -1);
+static std::vector<uint64_t> symbol_hashes;
+static std::deque<std::string> symbol_names;
+static symbol_table<llvm::Value *> named_vals;
+static symbol_table<llvm::Value *> const_vals;
+static symbol_table<std::shared_ptr<type>> var_types;
 static std::unique_ptr<llvm::orc::KaleidoscopeJIT> jit;
 static llvm::BasicBlock *break_bb;
+static llvm::Value *spawn_group;
+static std::vector<std::pair<llvm::Value *, uint64_t>> heap_arrays;
+static std::map<std::string, llvm::Function *> builtins;
+static std::map<std::string, std::list<param>> signatures;
+static bool optimize;
+static bool autopar;
+static bool hugepages;
+static bool fast_math;
+static bool autopar_report;
+static int par_depth;
+/* loops with reduce clause around generated code */
+static int reduce_depth;
+static bool stats;
+static bool compile_only;
+static bool compiling_unit;
+
+/* larger arrays are not allocated on stack */
+static const uint64_t STACK_ARRAY_MAX = 1 << 16;
+
+/* static arrays start at page, so file can be mapped over them */
+static const unsigned ARRAY_ALIGN = 4096;
+
+/* shorter loops are not worth starting threads */
+static const long int AUTOPAR_MIN_TRIP = 1000;
 
 llvm::Function *scanln_fun;
 llvm::Function *println_fun;
 llvm::Function *print_fun;
+llvm::Function *scanln_real_fun;
+llvm::Function *println_real_fun;
+llvm::Function *print_real_fun;
+llvm::Function *flush_fun;
+llvm::Function *write_fun;
+llvm::Function *eof_fun;
+llvm::Function *readarray_fun;
+llvm::Function *readarray_real_fun;
+llvm::Function *map_array_fun;
+llvm::Function *dump_array_fun;
+llvm::Function *par_for_fun;
+llvm::Function *par_lock_fun;
+llvm::Function *par_unlock_fun;
+llvm::Function *spawn_fun;
+llvm::Function *sync_fun;
+llvm::Function *alloc_array_fun;
+llvm::Function *free_array_fun;
+llvm::Function *hugepages_fun;
+
+/*
+ * create alloca in entry block of function so it is not repeated in loops
+ * and can be promoted to register
+ */
+static llvm::AllocaInst *create_entry_alloca(llvm::Function *fun,
+        llvm::Type *t, const std::string &name) {
+    auto &entry = fun->getEntryBlock();
+    llvm::IRBuilder<> tmp{&entry, entry.begin()};
+    return tmp.CreateAlloca(t, nullptr, name.c_str());
+}
+
+/*
+ * counter of running tasks spawned by current function, created on first
+ * use in entry block
+ */
+static llvm::Value *get_spawn_group() {
+    if (spawn_group != nullptr)
+        return spawn_group;
+    auto fun = builder.GetInsertBlock()->getParent();
+    auto a = create_entry_alloca(fun, llvm::Type::getInt64Ty(context),
+            "spawn_group");
+    llvm::IRBuilder<> tmp{&fun->getEntryBlock(), std::next(a->getIterator())};
+    tmp.CreateStore(llvm::ConstantInt::getSigned(
+                llvm::IntegerType::getInt64Ty(context), 0), a);
+    spawn_group = a;
+    return a;
+}
+
+/*
+ * Wait for spawned tasks before every return of function, ahead of the
+ * load of its result which a task may still write.
+ */
+static void sync_spawned(llvm::Function *fun) {
+    if (spawn_group == nullptr)
+        return;
+    for (auto &bb : *fun) {
+        auto ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(bb.getTerminator());
+        if (ret == nullptr)
+            continue;
+        llvm::Instruction *pos = ret;
+        auto res = llvm::dyn_cast_or_null<llvm::LoadInst>(ret->getReturnValue());
+        if (res != nullptr && res->getParent() == &bb)
+            pos = res;
+        llvm::CallInst::Create(sync_fun,
+                std::vector<llvm::Value *>{spawn_group}, "", pos);
+    }
+}
+
+/*
+ * program writes buffered output before each return, spawned calls are
+ * synced already
+ */
+static void flush_output(llvm::Function *fun) {
+    for (auto &bb : *fun) {
+        auto ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(bb.getTerminator());
+        if (ret != nullptr)
+            llvm::CallInst::Create(flush_fun, std::vector<llvm::Value *>{},
+                    "", ret);
+    }
+}
+
+/*
+ * release arrays allocated on heap by function before each return,
+ * after spawned calls are synced
+ */
+static void free_arrays(llvm::Function *fun) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    for (auto &bb : *fun) {
+        auto ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(bb.getTerminator());
+        if (ret == nullptr)
+            continue;
+        llvm::IRBuilder<> tmp{ret};
+        for (auto &a : heap_arrays)
+            tmp.CreateCall(free_array_fun, std::vector<llvm::Value *>{
+                    tmp.CreateBitCast(a.first,
+                        llvm::Type::getInt8PtrTy(context)),
+                    llvm::ConstantInt::get(i64, a.second)});
+    }
+}
+
+/*
+ * thunk void (i64 *args) of spawned function, calls it with args and
+ * stores result at address in the slot after arguments
+ */
+static llvm::Function *spawn_thunk(llvm::Function *fun) {
+    auto name = fun->getName().str() + ".spawn";
+    auto thunk = module->getFunction(name);
+    if (thunk != nullptr)
+        return thunk;
+
+    auto i64p = llvm::Type::getInt64PtrTy(context);
+    auto prev_bb = builder.GetInsertBlock();
+    thunk = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{i64p}, false),
+            llvm::Function::InternalLinkage, name, module.get());
+    auto args = &*thunk->arg_begin();
+    args->setName("args");
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", thunk));
+
+    auto p = std::vector<llvm::Value *>{};
+    for (size_t k = 0; k < fun->arg_size(); ++k)
+        p.push_back(builder.CreateLoad(
+                    builder.CreateConstInBoundsGEP1_64(args, k)));
+    auto r = builder.CreateCall(fun, p);
+    if (!fun->getReturnType()->isVoidTy()) {
+        auto dest = builder.CreateLoad(
+                builder.CreateConstInBoundsGEP1_64(args, fun->arg_size()));
+        builder.CreateStore(r, builder.CreateIntToPtr(dest, i64p));
+    }
+    builder.CreateRetVoid();
+    verifyFunction(*thunk);
+
+    builder.SetInsertPoint(prev_bb);
+    return thunk;
+}
+
+/*
+ * neutral element of reduction operator
+ */
+static llvm::Value *reduce_identity(int op, llvm::Type *t) {
+    if (t->isDoubleTy()) {
+        switch (op) {
+            case RED_PROD:
+                return llvm::ConstantFP::get(t, 1.0);
+            case RED_MIN:
+                return llvm::ConstantFP::getInfinity(t, false);
+            case RED_MAX:
+                return llvm::ConstantFP::getInfinity(t, true);
+            default:
+                return llvm::ConstantFP::get(t, 0.0);
+        }
+    }
+    switch (op) {
+        case RED_PROD:
+            return llvm::ConstantInt::getSigned(t, 1);
+        case RED_MIN:
+            return llvm::ConstantInt::getSigned(t,
+                    std::numeric_limits<int64_t>::max());
+        case RED_MAX:
+            return llvm::ConstantInt::getSigned(t,
+                    std::numeric_limits<int64_t>::min());
+        case RED_AND:
+            return llvm::ConstantInt::getSigned(t, -1);
+        default:
+            return llvm::ConstantInt::getSigned(t, 0);
+    }
+}
+
+/*
+ * merge two partial results of reduction operator
+ */
+static llvm::Value *reduce_combine(int op, llvm::Value *a, llvm::Value *b) {
+    if (a->getType()->isDoubleTy()) {
+        switch (op) {
+            case RED_SUM:
+                return builder.CreateFAdd(a, b, "sum");
+            case RED_PROD:
+                return builder.CreateFMul(a, b, "product");
+            case RED_MIN:
+                return builder.CreateSelect(builder.CreateFCmpOLT(a, b), a, b,
+                        "min");
+            case RED_MAX:
+                return builder.CreateSelect(builder.CreateFCmpOGT(a, b), a, b,
+                        "max");
+            default:
+                std::cout << "reduce error" << std::endl;
+                return a;
+        }
+    }
+    switch (op) {
+        case RED_SUM:
+            return builder.CreateAdd(a, b, "sum");
+        case RED_PROD:
+            return builder.CreateMul(a, b, "product");
+        case RED_MIN:
+            return builder.CreateSelect(builder.CreateICmpSLT(a, b), a, b, "min");
+        case RED_MAX:
+            return builder.CreateSelect(builder.CreateICmpSGT(a, b), a, b, "max");
+        case RED_AND:
+            return builder.CreateAnd(a, b, "and");
+        default:
+            return builder.CreateOr(a, b, "or");
+    }
+}
+
+/*
+ * ask loop vectorizer to vectorize loop ending with latch branch
+ */
+static void mark_vectorize(llvm::BranchInst *latch) {
+    auto enable = llvm::MDNode::get(context, std::vector<llvm::Metadata *>{
+            llvm::MDString::get(context, "llvm.loop.vectorize.enable"),
+            llvm::ConstantAsMetadata::get(builder.getTrue())});
+    /* first operand of loop id is reference to itself */
+    auto loop_id = llvm::MDNode::get(context,
+            std::vector<llvm::Metadata *>{nullptr, enable});
+    loop_id->replaceOperandWith(0, loop_id);
+    latch->setMetadata("llvm.loop", loop_id);
+}
+
+/*
+ * arithmetic on affine subscripts, sign -1 subtracts b from a
+ */
+static affine affine_add(const affine &a, const affine &b, long int sign) {
+    auto r = affine{a.index + sign * b.index, a.terms, a.k + sign * b.k};
+    for (auto &t : b.terms) {
+        r.terms[t.first] += sign * t.second;
+        if (r.terms[t.first] == 0)
+            r.terms.erase(t.first);
+    }
+    return r;
+}
+
+static affine affine_scale(const affine &a, long int c) {
+    auto r = affine{a.index * c, {}, a.k * c};
+    if (c != 0)
+        for (auto &t : a.terms)
+            r.terms[t.first] = t.second * c;
+    return r;
+}
+
+static bool affine_const(const affine &a) {
+    return a.index == 0 && a.terms.empty();
+}
+
+static long int gcd(long int a, long int b) {
+    a = a < 0 ? -a : a;
+    b = b < 0 ? -b : b;
+    while (b != 0) {
+        auto t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/*
+ * Subscripts of array access, invalid when some of them is not affine.
+ */
+static access make_access(loop_info &l, const std::string &name,
+        const std::list<expr *> &idxs, bool write) {
+    auto a = access{name, {}, true, write};
+    for (auto e : idxs) {
+        auto s = affine{0, {}, 0};
+        a.valid = e->affine_form(l.index, s) && a.valid;
+        a.subs.push_back(s);
+    }
+    return a;
+}
+
+/*
+ * True when accesses a and b touch the same element only within one
+ * iteration. One subscript telling elements apart is enough: the same
+ * injective function of index, or no solution of index * i1 + k1 =
+ * index * i2 + k2 (GCD test). Subscripts using variables written in the
+ * loop are not invariant and cannot be compared.
+ */
+static bool independent(const access &a, const access &b,
+        const std::set<std::string> &writes) {
+    if (!a.valid || !b.valid || a.subs.size() != b.subs.size())
+        return false;
+    for (size_t d = 0; d < a.subs.size(); ++d) {
+        auto &x = a.subs[d];
+        auto &y = b.subs[d];
+        auto invariant = true;
+        for (auto &t : x.terms)
+            invariant = invariant && writes.count(t.first) == 0;
+        if (!invariant || x.terms != y.terms)
+            continue;
+        if (x.index == y.index && x.index != 0 && x.k == y.k)
+            return true;
+        auto g = gcd(x.index, y.index);
+        if (g == 0 ? x.k != y.k : (y.k - x.k) % g != 0)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * true for variables holding whole array
+ */
+static bool is_array(const std::string &name) {
+    return const_vals.count(name) != 0
+        && const_vals.get(name)->getType()->getPointerElementType()->isArrayTy();
+}
+
+/*
+ * true for array and var parameters, they are passed by reference and
+ * caller may pass the same memory for several of them, e.g. P(A[5], A)
+ */
+static bool is_ref_param(const std::string &name) {
+    return const_vals.count(name) != 0
+        && llvm::isa<llvm::Argument>(const_vals.get(name)->stripPointerCasts());
+}
+
+/*
+ * Row-major position of array element, indices are in bounds of array
+ * declaration and missing trailing indices are lower bounds. Offset
+ * arithmetic does not wrap so loop optimizations can strength reduce it.
+ */
+static llvm::Value *array_pos(const std::string &name,
+        const std::vector<llvm::Value *> &idx) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto bounds = var_types.get(name)->get_bounds();
+    if (idx.size() > bounds.size())
+        std::cout << "index error: " << name << std::endl;
+    llvm::Value *pos = nullptr;
+    for (size_t d = 0; d < bounds.size(); ++d) {
+        auto len = bounds[d].second - bounds[d].first + 1;
+        auto i = d < idx.size() ? builder.CreateNSWSub(idx[d],
+                llvm::ConstantInt::getSigned(i64, bounds[d].first))
+            : llvm::ConstantInt::get(i64, 0);
+        pos = pos == nullptr ? i : builder.CreateNSWAdd(builder.CreateNSWMul(
+                    pos, llvm::ConstantInt::get(i64, len)), i);
+    }
+    return pos;
+}
+
+/*
+ * address of array element, array is one block in row-major order
+ */
+static llvm::Value *array_elem(const std::string &name,
+        const std::vector<llvm::Value *> &idx) {
+    return builder.CreateInBoundsGEP(const_vals.get(name),
+            {llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), 0),
+            array_pos(name, idx)});
+}
+
+static bool is_packed(const std::string &name) {
+    return var_types.count(name) != 0
+        && var_types.get(name)->get_type() == TYPE_PACKED;
+}
+
+/*
+ * address of word of packed array holding element, bit is set to its
+ * position in the word
+ */
+static llvm::Value *bit_word(const std::string &name,
+        const std::vector<llvm::Value *> &idx, llvm::Value *&bit) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto pos = array_pos(name, idx);
+    bit = builder.CreateAnd(pos, llvm::ConstantInt::get(i64, 63), "bit");
+    return builder.CreateInBoundsGEP(const_vals.get(name),
+            {llvm::ConstantInt::get(i64, 0),
+            builder.CreateLShr(pos, llvm::ConstantInt::get(i64, 6))});
+}
+
+/*
+ * number of elements of array, open array keeps it in hidden variable
+ */
+static llvm::Value *array_len(const std::string &name) {
+    auto len = const_vals.get(name + ".len");
+    if (len != nullptr)
+        return builder.CreateLoad(len, "len");
+    return llvm::ConstantInt::get(llvm::Type::getInt64Ty(context),
+            const_vals.get(name)->getType()->getPointerElementType()
+            ->getArrayNumElements());
+}
+
+/*
+ * size in bytes of len elements of array at ptr
+ */
+static llvm::Value *array_bytes(llvm::Value *ptr, llvm::Value *len) {
+    auto elem = ptr->getType()->getPointerElementType()->getArrayElementType();
+    return builder.CreateMul(len,
+            llvm::ConstantInt::get(llvm::Type::getInt64Ty(context),
+                module->getDataLayout().getTypeAllocSize(elem)));
+}
+
+/*
+ * LLVM type of array element
+ */
+static llvm::Type *elem_type(const type &t) {
+    if (t.is_real())
+        return llvm::Type::getDoubleTy(context);
+    return llvm::IntegerType::get(context, t.get_bits());
+}
+
+static bool is_scalar(int t) {
+    return t == TYPE_INT || t == TYPE_BOOL || t == TYPE_REAL;
+}
+
+/*
+ * LLVM type of scalar variable, integers are always 64 bits wide
+ */
+static llvm::Type *scalar_type(const type &t) {
+    if (t.get_type() == TYPE_BOOL)
+        return llvm::Type::getInt1Ty(context);
+    if (t.get_type() == TYPE_REAL)
+        return llvm::Type::getDoubleTy(context);
+    return llvm::Type::getInt64Ty(context);
+}
+
+/*
+ * Load of variable or array element widened to 64 bits by signedness of
+ * array element type.
+ */
+static llvm::Value *load_elem(const std::string &name, llvm::Value *ptr) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto v = builder.CreateLoad(ptr, name.c_str());
+    if (v->getType() == i64 || v->getType()->isIntegerTy(1)
+            || v->getType()->isDoubleTy())
+        return v;
+    if (var_types.get(name)->is_signed())
+        return builder.CreateSExt(v, i64);
+    return builder.CreateZExt(v, i64);
+}
+
+/*
+ * truth value used as integer is 0 or 1
+ */
+static llvm::Value *widen(llvm::Value *v) {
+    if (!v->getType()->isIntegerTy(1))
+        return v;
+    return builder.CreateZExt(v, llvm::Type::getInt64Ty(context));
+}
+
+/*
+ * integer used where real is expected
+ */
+static llvm::Value *to_real(llvm::Value *v) {
+    if (v->getType()->isDoubleTy())
+        return v;
+    return builder.CreateSIToFP(widen(v), llvm::Type::getDoubleTy(context));
+}
+
+/*
+ * number used as condition is true when not zero
+ */
+static llvm::Value *as_cond(llvm::Value *v) {
+    if (v->getType()->isIntegerTy(1))
+        return v;
+    if (v->getType()->isDoubleTy())
+        return builder.CreateFCmpUNE(v, llvm::ConstantFP::get(v->getType(), 0));
+    return builder.CreateICmpNE(v, llvm::ConstantInt::get(v->getType(), 0));
+}
+
+/*
+ * Operands of binary operator of different types, integer is converted to
+ * real and truth value is widened to integer. True when operation is real.
+ */
+static bool promote(llvm::Value *&l, llvm::Value *&r) {
+    if (l->getType()->isDoubleTy() || r->getType()->isDoubleTy()) {
+        l = to_real(l);
+        r = to_real(r);
+        return true;
+    }
+    l = widen(l);
+    r = widen(r);
+    return false;
+}
+
+/*
+ * Store to variable or array element truncated to its width, real is not
+ * converted to integer implicitly.
+ */
+static llvm::Value *store_elem(llvm::Value *v, llvm::Value *ptr) {
+    auto t = ptr->getType()->getPointerElementType();
+    if (t->isIntegerTy(1))
+        return builder.CreateStore(as_cond(v), ptr);
+    if (t->isDoubleTy())
+        return builder.CreateStore(to_real(v), ptr);
+    if (v->getType()->isDoubleTy()) {
+        std::cout << "type error: use trunc or round" << std::endl;
+        v = builder.CreateFPToSI(v, t);
+    }
+    return builder.CreateStore(builder.CreateZExtOrTrunc(v, t), ptr);
+}
+
+static llvm::Value *load_bit(const std::string &name,
+        const std::vector<llvm::Value *> &idx) {
+    llvm::Value *bit = nullptr;
+    auto w = builder.CreateLoad(bit_word(name, idx, bit), name.c_str());
+    return builder.CreateTrunc(builder.CreateLShr(w, bit),
+            llvm::Type::getInt1Ty(context));
+}
+
+/*
+ * word of packed array is read, element bit changed and word written back
+ */
+static llvm::Value *store_bit(const std::string &name,
+        const std::vector<llvm::Value *> &idx, llvm::Value *v) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    llvm::Value *bit = nullptr;
+    auto ptr = bit_word(name, idx, bit);
+    auto w = builder.CreateLoad(ptr, name.c_str());
+    auto mask = builder.CreateShl(llvm::ConstantInt::get(i64, 1), bit);
+    auto set = builder.CreateShl(widen(as_cond(v)), bit);
+    return builder.CreateStore(builder.CreateOr(
+                builder.CreateAnd(w, builder.CreateNot(mask)), set), ptr);
+}
+
+static std::vector<llvm::Value *> gen_idxs(const std::list<expr *> &idxs) {
+    auto idx = std::vector<llvm::Value *>{};
+    for (auto e : idxs)
+        idx.push_back(e->gen_ir());
+    return idx;
+}
+
+/*
+ * runtime function of built-in, user function of the same name hides it
+ */
+static llvm::Function *builtin_fun(const std::string &name) {
+    if (module->getFunction(name) != nullptr || builtins.count(name) == 0)
+        return nullptr;
+    return builtins[name];
+}
+
+/*
+ * Built-in over array of narrow integers or reals is loop in generated
+ * code, vector of narrow elements holds more of them than runtime function
+ * processes. Sum of reals is vectorized only with -ffast-math.
+ */
+static llvm::Value *gen_builtin_loop(const std::string &name,
+        var_access *arr, llvm::Value *ptr, const std::list<expr *> &params) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto real = var_types.get(arr->get_name())->is_real();
+    auto t = real && name != "count" ? llvm::Type::getDoubleTy(context) : i64;
+    auto len = array_len(arr->get_name());
+    auto x = params.size() > 1 ? widen(params.back()->gen_ir()) : nullptr;
+    if (real && x != nullptr)
+        x = to_real(x);
+    llvm::Value *init = llvm::Constant::getNullValue(t);
+    if (name == "max")
+        init = real ? llvm::ConstantFP::getInfinity(t, true)
+            : llvm::ConstantInt::getSigned(i64, INT64_MIN);
+    else if (name == "min")
+        init = real ? llvm::ConstantFP::getInfinity(t, false)
+            : llvm::ConstantInt::getSigned(i64, INT64_MAX);
+
+    auto pre = builder.GetInsertBlock();
+    auto fun = pre->getParent();
+    auto loop = llvm::BasicBlock::Create(context, name, fun);
+    auto after = llvm::BasicBlock::Create(context, name + "_end", fun);
+    builder.CreateCondBr(builder.CreateICmpSGT(len, llvm::ConstantInt::get(i64, 0)),
+            loop, after);
+    builder.SetInsertPoint(loop);
+    auto i = builder.CreatePHI(i64, 2, "i");
+    auto acc = builder.CreatePHI(t, 2, name);
+    i->addIncoming(llvm::ConstantInt::get(i64, 0), pre);
+    acc->addIncoming(init, pre);
+    auto p = builder.CreateInBoundsGEP(ptr,
+            {llvm::ConstantInt::get(i64, 0), i});
+    auto e = widen(load_elem(arr->get_name(), p));
+    llvm::Value *next_acc = nullptr;
+    if (name == "max")
+        next_acc = builder.CreateSelect(real ? builder.CreateFCmpOGT(e, acc)
+                : builder.CreateICmpSGT(e, acc), e, acc);
+    else if (name == "min")
+        next_acc = builder.CreateSelect(real ? builder.CreateFCmpOLT(e, acc)
+                : builder.CreateICmpSLT(e, acc), e, acc);
+    else if (name == "count")
+        next_acc = builder.CreateAdd(acc, builder.CreateZExt(real
+                    ? builder.CreateFCmpOEQ(e, x) : builder.CreateICmpEQ(e, x),
+                    i64));
+    else if (real)
+        next_acc = builder.CreateFAdd(acc, e);
+    else
+        next_acc = builder.CreateAdd(acc, e);
+    if (name == "prefixsum")
+        store_elem(next_acc, p);
+    auto next = builder.CreateAdd(i, llvm::ConstantInt::get(i64, 1), "i");
+    i->addIncoming(next, loop);
+    acc->addIncoming(next_acc, loop);
+    mark_vectorize(builder.CreateCondBr(builder.CreateICmpNE(next, len),
+                loop, after));
+
+    builder.SetInsertPoint(after);
+    auto r = builder.CreatePHI(t, 2, name);
+    r->addIncoming(init, pre);
+    r->addIncoming(next_acc, loop);
+    return r;
+}
+
+/*
+ * Elements of packed array equal to v are counted by popcount of words,
+ * bits of the last word past the end are masked.
+ */
+static llvm::Value *gen_packed_count(var_access *arr, llvm::Value *ptr,
+        expr *x) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto t = var_types.get(arr->get_name());
+    auto words = t->get_size();
+    auto bits = static_cast<packed_array_type *>(t.get())->get_length();
+    auto v = as_cond(x->gen_ir());
+    auto ctpop = llvm::Intrinsic::getDeclaration(module.get(),
+            llvm::Intrinsic::ctpop, std::vector<llvm::Type *>{i64});
+
+    auto pre = builder.GetInsertBlock();
+    llvm::Value *n = llvm::ConstantInt::get(i64, 0);
+    if (words > 1) {
+        auto fun = pre->getParent();
+        auto loop = llvm::BasicBlock::Create(context, "count", fun);
+        auto after = llvm::BasicBlock::Create(context, "count_end", fun);
+        builder.CreateBr(loop);
+        builder.SetInsertPoint(loop);
+        auto i = builder.CreatePHI(i64, 2, "i");
+        auto acc = builder.CreatePHI(i64, 2, "count");
+        i->addIncoming(llvm::ConstantInt::get(i64, 0), pre);
+        acc->addIncoming(n, pre);
+        auto w = builder.CreateLoad(builder.CreateInBoundsGEP(ptr,
+                    {llvm::ConstantInt::get(i64, 0), i}));
+        n = builder.CreateAdd(acc, builder.CreateCall(ctpop,
+                    std::vector<llvm::Value *>{w}), "count");
+        auto next = builder.CreateAdd(i, llvm::ConstantInt::get(i64, 1), "i");
+        i->addIncoming(next, loop);
+        acc->addIncoming(n, loop);
+        mark_vectorize(builder.CreateCondBr(builder.CreateICmpNE(next,
+                        llvm::ConstantInt::get(i64, words - 1)), loop, after));
+        builder.SetInsertPoint(after);
+    }
+    llvm::Value *last = builder.CreateLoad(
+            builder.CreateConstInBoundsGEP2_64(ptr, 0, words - 1));
+    if (bits % 64 != 0)
+        last = builder.CreateAnd(last, llvm::ConstantInt::get(i64,
+                    (uint64_t{1} << (bits % 64)) - 1));
+    n = builder.CreateAdd(n, builder.CreateCall(ctpop,
+                std::vector<llvm::Value *>{last}), "count");
+    return builder.CreateSelect(v, n, builder.CreateSub(
+                llvm::ConstantInt::get(i64, bits), n));
+}
+
+/*
+ * Built-ins take whole array as first argument, runtime gets address of
+ * its first element and number of elements.
+ */
+static llvm::Value *call_builtin(const std::string &name, llvm::Function *fun,
+        const std::list<expr *> &params) {
+    auto arr = params.empty() ? nullptr : params.front()->as_var_access();
+    auto ptr = arr == nullptr ? nullptr : arr->array_ref();
+    if (ptr == nullptr || params.size() + 1 != fun->arg_size()) {
+        std::cout << "builtin error: " << name << std::endl;
+        return nullptr;
+    }
+    if (is_packed(arr->get_name())) {
+        if (name == "count")
+            return gen_packed_count(arr, ptr, params.back());
+        std::cout << "builtin error: " << name << std::endl;
+        return nullptr;
+    }
+    if (var_types.get(arr->get_name())->get_bits() != 64
+            || var_types.get(arr->get_name())->is_real())
+        return gen_builtin_loop(name, arr, ptr, params);
+    auto p = std::vector<llvm::Value *>{
+        builder.CreateConstInBoundsGEP2_64(ptr, 0, 0),
+        array_len(arr->get_name())};
+    for (auto e = std::next(params.begin()); e != params.end(); ++e)
+        p.push_back((*e)->gen_ir());
+    return builder.CreateCall(fun, p);
+}
+
+/*
+ * trunc(x) and round(x) convert real to integer
+ */
+static bool conversion(const std::string &name) {
+    return (name == "trunc" || name == "round")
+        && module->getFunction(name) == nullptr;
+}
+
+static llvm::Value *gen_conversion(const std::string &name,
+        const std::list<expr *> &params) {
+    if (params.size() != 1) {
+        std::cout << "builtin error: " << name << std::endl;
+        return nullptr;
+    }
+    auto v = to_real(params.front()->gen_ir());
+    if (name == "round")
+        v = builder.CreateCall(llvm::Intrinsic::getDeclaration(module.get(),
+                    llvm::Intrinsic::round,
+                    std::vector<llvm::Type *>{v->getType()}),
+                std::vector<llvm::Value *>{v});
+    return builder.CreateFPToSI(v, llvm::Type::getInt64Ty(context), name);
+}
+
+/*
+ * fill(A, v) and copy(A, i, B, j, n) are lowered to memset, memmove or
+ * loop in generated code
+ */
+static bool lowered_builtin(const std::string &name) {
+    return (name == "fill" || name == "copy")
+        && module->getFunction(name) == nullptr;
+}
+
+/*
+ * Value with all bytes equal is stored by memset, other values by loop
+ * which vectorizer turns to vector stores.
+ */
+static llvm::Value *gen_fill(const std::list<expr *> &params) {
+    auto arr = params.empty() ? nullptr : params.front()->as_var_access();
+    auto ptr = arr == nullptr ? nullptr : arr->array_ref();
+    if (ptr == nullptr || params.size() != 2) {
+        std::cout << "fill error" << std::endl;
+        return nullptr;
+    }
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto len = array_len(arr->get_name());
+    if (is_packed(arr->get_name()))
+        return builder.CreateMemSet(ptr, builder.CreateSExt(
+                    as_cond(params.back()->gen_ir()), builder.getInt8Ty()),
+                array_bytes(ptr, len), 8);
+    auto v = params.back()->gen_ir();
+    auto t = elem_type(*var_types.get(arr->get_name()));
+    if (t->isDoubleTy())
+        v = to_real(v);
+    else
+        v = t->isIntegerTy(1) ? as_cond(v) : builder.CreateZExtOrTrunc(v, t);
+    auto z = llvm::dyn_cast<llvm::Constant>(v);
+    if (z != nullptr && z->isNullValue())
+        return builder.CreateMemSet(ptr, builder.getInt8(0),
+                array_bytes(ptr, len), 8);
+
+    auto c = llvm::dyn_cast<llvm::ConstantInt>(v);
+    if (c != nullptr) {
+        auto x = c->getZExtValue();
+        auto splat = true;
+        for (unsigned k = 8; k < c->getBitWidth(); k += 8)
+            splat = splat && ((x >> k) & 0xff) == (x & 0xff);
+        if (splat)
+            return builder.CreateMemSet(ptr, builder.getInt8(x & 0xff),
+                    array_bytes(ptr, len), 8);
+    }
+
+    auto pre = builder.GetInsertBlock();
+    auto fun = pre->getParent();
+    auto loop = llvm::BasicBlock::Create(context, "fill", fun);
+    auto after = llvm::BasicBlock::Create(context, "fill_end", fun);
+    builder.CreateBr(loop);
+    builder.SetInsertPoint(loop);
+    auto i = builder.CreatePHI(i64, 2, "i");
+    i->addIncoming(llvm::ConstantInt::get(i64, 0), pre);
+    builder.CreateStore(v, builder.CreateInBoundsGEP(ptr,
+                {llvm::ConstantInt::get(i64, 0), i}));
+    auto next = builder.CreateAdd(i, llvm::ConstantInt::get(i64, 1), "i");
+    i->addIncoming(next, loop);
+    mark_vectorize(builder.CreateCondBr(builder.CreateICmpNE(next, len),
+                loop, after));
+    builder.SetInsertPoint(after);
+    return after;
+}
+
+/*
+ * copy n elements from B[j] to A[i], ranges may overlap
+ */
+static llvm::Value *gen_copy(const std::list<expr *> &params) {
+    if (params.size() != 5) {
+        std::cout << "copy error" << std::endl;
+        return nullptr;
+    }
+    auto it = params.begin();
+    auto a = (*it++)->as_var_access();
+    auto i = *it++;
+    auto b = (*it++)->as_var_access();
+    auto j = *it++;
+    auto n = *it;
+    if (a == nullptr || a->array_ref() == nullptr
+            || b == nullptr || b->array_ref() == nullptr
+            || var_types.get(a->get_name())->get_bits()
+            != var_types.get(b->get_name())->get_bits()
+            || var_types.get(a->get_name())->is_real()
+            != var_types.get(b->get_name())->is_real()
+            || is_packed(a->get_name()) || is_packed(b->get_name())) {
+        std::cout << "copy error" << std::endl;
+        return nullptr;
+    }
+    auto elem = a->array_ref()->getType()->getPointerElementType()
+        ->getArrayElementType();
+    auto dst = array_elem(a->get_name(), {i->gen_ir()});
+    auto src = array_elem(b->get_name(), {j->gen_ir()});
+    auto size = builder.CreateMul(n->gen_ir(),
+            llvm::ConstantInt::get(llvm::Type::getInt64Ty(context),
+                module->getDataLayout().getTypeAllocSize(elem)));
+    return builder.CreateMemMove(dst, src, size, 8);
+}
+
+/*
+ * readarray(A, n) reads at most n numbers into A, mapread(A, k) and
+ * mapcopy(A, k) map file given as k-th program argument over A, dump(A, k)
+ * writes A to such file. All of them return number of elements.
+ */
+static bool io_builtin(const std::string &name) {
+    return (name == "readarray" || name == "mapread" || name == "mapcopy"
+            || name == "dump") && module->getFunction(name) == nullptr;
+}
+
+/*
+ * One runtime call parses numbers straight to memory of array, narrow
+ * integer elements are stored by size of element.
+ */
+static llvm::Value *gen_readarray(const std::list<expr *> &params) {
+    auto arr = params.empty() ? nullptr : params.front()->as_var_access();
+    auto ptr = arr == nullptr ? nullptr : arr->array_ref();
+    if (ptr == nullptr || params.size() != 2 || is_packed(arr->get_name())
+            || elem_type(*var_types.get(arr->get_name()))->isIntegerTy(1)) {
+        std::cout << "readarray error" << std::endl;
+        return nullptr;
+    }
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto first = builder.CreateConstInBoundsGEP2_64(ptr, 0, 0);
+    auto len = array_len(arr->get_name());
+    auto n = widen(params.back()->gen_ir());
+    if (var_types.get(arr->get_name())->is_real())
+        return builder.CreateCall(readarray_real_fun,
+                std::vector<llvm::Value *>{first, len, n}, "readarray");
+    return builder.CreateCall(readarray_fun, std::vector<llvm::Value *>{
+            builder.CreateBitCast(first, builder.getInt8PtrTy()), len, n,
+            llvm::ConstantInt::get(i64,
+                    var_types.get(arr->get_name())->get_bits() / 8)},
+            "readarray");
+}
+
+/*
+ * true for array in page aligned storage of its own, static array of
+ * program or array allocated by runtime
+ */
+static bool own_pages(llvm::Value *ptr) {
+    auto v = ptr->stripPointerCasts();
+    if (auto g = llvm::dyn_cast<llvm::GlobalVariable>(v))
+        return g->getAlignment() >= ARRAY_ALIGN;
+    auto c = llvm::dyn_cast<llvm::CallInst>(v);
+    return c != nullptr && c->getCalledFunction() == alloc_array_fun;
+}
+
+/*
+ * Array file holds raw elements in memory layout of array, runtime maps
+ * or writes it as bytes.
+ */
+static llvm::Value *gen_array_file(const std::string &name,
+        const std::list<expr *> &params) {
+    auto arr = params.empty() ? nullptr : params.front()->as_var_access();
+    auto ptr = arr == nullptr ? nullptr : arr->array_ref();
+    if (ptr == nullptr || params.size() != 2) {
+        std::cout << "builtin error: " << name << std::endl;
+        return nullptr;
+    }
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto elem = ptr->getType()->getPointerElementType()->getArrayElementType();
+    auto p = builder.CreateBitCast(ptr, builder.getInt8PtrTy());
+    auto bytes = array_bytes(ptr, array_len(arr->get_name()));
+    auto k = widen(params.back()->gen_ir());
+    auto flags = (name == "mapcopy" ? SFE_MAP_WRITABLE : 0)
+        | (own_pages(ptr) ? SFE_MAP_PAGES : 0);
+    auto n = name == "dump"
+        ? builder.CreateCall(dump_array_fun,
+                std::vector<llvm::Value *>{p, bytes, k})
+        : builder.CreateCall(map_array_fun, std::vector<llvm::Value *>{p,
+                bytes, k, llvm::ConstantInt::get(i64, flags)});
+    return builder.CreateUDiv(n, llvm::ConstantInt::get(i64,
+                module->getDataLayout().getTypeAllocSize(elem)), name);
+}
+
+static llvm::Value *gen_io_builtin(const std::string &name,
+        const std::list<expr *> &params) {
+    if (name == "readarray")
+        return gen_readarray(params);
+    return gen_array_file(name, params);
+}
+
+/*
+ * built-in reads its array arguments, writes the first one when it is
+ * lowered or runtime function may write memory
+ */
+static bool builtin_deps(loop_info &l, const std::string &name,
+        const std::list<expr *> &params) {
+    auto fun = builtin_fun(name);
+    if (io_builtin(name)) {
+        l.forbid("performs input or output");
+        return true;
+    }
+    if (conversion(name)) {
+        for (auto e : params)
+            e->deps(l);
+        return true;
+    }
+    if (fun == nullptr && !lowered_builtin(name))
+        return false;
+    for (auto e : params)
+        e->deps(l);
+    auto v = params.empty() ? nullptr : params.front()->as_var_access();
+    if (v != nullptr && (fun == nullptr || !fun->onlyReadsMemory()))
+        l.arrays.push_back(access{v->get_name(), {}, false, true});
+    return true;
+}
+
+/*
+ * Function with parameters, arrays and var parameters are passed by address
+ * and open arrays as address of the first element followed by length.
+ */
+static llvm::Function *declare_fun(const std::string &name, llvm::Type *ret,
+        const std::list<param> &args) {
+    auto fun = module->getFunction(name);
+    if (fun != nullptr)
+        return fun;
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto types = std::vector<llvm::Type *>{};
+    for (auto &a : args) {
+        auto t = a.par_type->get_type();
+        if (t == TYPE_ARR || t == TYPE_PACKED) {
+            types.push_back(llvm::ArrayType::get(elem_type(*a.par_type),
+                        a.par_type->get_size())->getPointerTo());
+        } else if (t == TYPE_OPEN_ARR) {
+            types.push_back(elem_type(*a.par_type)->getPointerTo());
+            types.push_back(i64);
+        } else if (a.by_ref) {
+            types.push_back(scalar_type(*a.par_type)->getPointerTo());
+        } else {
+            types.push_back(scalar_type(*a.par_type));
+        }
+    }
+    fun = llvm::Function::Create(llvm::FunctionType::get(ret, types, false),
+            llvm::Function::ExternalLinkage, name, module.get());
+    auto arg = fun->arg_begin();
+    for (auto &a : args) {
+        (arg++)->setName(a.name);
+        if (a.par_type->get_type() == TYPE_OPEN_ARR)
+            (arg++)->setName(a.name + ".len");
+    }
+
+    /* only spawned calls outlive caller and they take no pointers */
+    for (auto &a : fun->args())
+        if (a.getType()->isPointerTy())
+            fun->setDoesNotCapture(a.getArgNo() + 1);
+    signatures[name] = args;
+    return fun;
+}
+
+/*
+ * formal parameters in syntax of source, one section per parameter
+ */
+static void print_params(std::ostream &out, const std::list<param> &args) {
+    if (args.empty())
+        return;
+    out << "(";
+    for (auto &a : args) {
+        out << (&a == &args.front() ? "" : "; ") << (a.by_ref ? "var " : "")
+            << a.name << " : ";
+        a.par_type->print(out);
+    }
+    out << ")";
+}
+
+/*
+ * Make parameters visible in body of function. Scalars are copied to
+ * allocas, arrays and var parameters are used in place.
+ */
+static void bind_params(llvm::Function *fun, const std::list<param> &args) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto arg = fun->arg_begin();
+    for (auto &a : args) {
+        auto t = a.par_type->get_type();
+        llvm::Value *v = &*(arg++);
+        if (t == TYPE_OPEN_ARR) {
+            v = builder.CreateBitCast(v, llvm::ArrayType::get(
+                        elem_type(*a.par_type), 0)->getPointerTo(), a.name);
+            auto len = builder.CreateAlloca(i64, nullptr, a.name + ".len");
+            builder.CreateStore(&*(arg++), len);
+            const_vals.set(a.name + ".len", len);
+        } else if (is_scalar(t) && !a.by_ref) {
+            auto p = builder.CreateAlloca(v->getType(), nullptr, a.name);
+            builder.CreateStore(v, p);
+            v = p;
+        }
+        named_vals.set(a.name, v);
+        const_vals.set(a.name, v);
+        var_types.set(a.name, a.par_type);
+    }
+}
+
+/*
+ * Arguments of call of user function by its parameters, the caller
+ * keeps ownership of arrays.
+ */
+static std::vector<llvm::Value *> gen_args(llvm::Function *fun,
+        const std::string &name, const std::list<expr *> &params) {
+    auto p = std::vector<llvm::Value *>{};
+    auto sig = signatures.find(name);
+    if (sig == signatures.end() || sig->second.size() != params.size()) {
+        for (auto e : params)
+            p.push_back(e->gen_ir());
+        return p;
+    }
+    auto it = sig->second.begin();
+    for (auto e : params) {
+        auto by_ref = it->by_ref;
+        auto t = (it++)->par_type->get_type();
+        auto v = e->as_var_access();
+        auto expected = fun->getFunctionType()->getParamType(p.size());
+        if (is_scalar(t) && by_ref) {
+            /* variable or array element, constants cannot change */
+            auto ptr = v == nullptr || named_vals.count(v->get_name()) == 0
+                || v->array_ref() != nullptr || is_packed(v->get_name())
+                ? nullptr : v->get_ptr();
+            if (ptr == nullptr || ptr->getType() != expected) {
+                std::cout << "call error: " << name << std::endl;
+                ptr = llvm::UndefValue::get(expected);
+            }
+            p.push_back(ptr);
+            continue;
+        }
+        if (t == TYPE_INT) {
+            auto a = widen(e->gen_ir());
+            if (a->getType()->isDoubleTy()) {
+                std::cout << "call error: " << name << std::endl;
+                a = llvm::UndefValue::get(expected);
+            }
+            p.push_back(a);
+            continue;
+        }
+        if (t == TYPE_REAL) {
+            p.push_back(to_real(e->gen_ir()));
+            continue;
+        }
+        if (t == TYPE_BOOL) {
+            p.push_back(as_cond(e->gen_ir()));
+            continue;
+        }
+        /* packed array is passed only as packed array */
+        auto ptr = v == nullptr || (t == TYPE_PACKED) != is_packed(v->get_name())
+            ? nullptr : v->array_ref();
+        auto elem = ptr == nullptr ? nullptr
+            : ptr->getType()->getPointerElementType()->getArrayElementType();
+        if (ptr != nullptr && t == TYPE_OPEN_ARR
+                && elem == expected->getPointerElementType()) {
+            p.push_back(builder.CreateConstInBoundsGEP2_64(ptr, 0, 0));
+            p.push_back(array_len(v->get_name()));
+            continue;
+        }
+        /* open array is trusted to be long enough */
+        if (ptr == nullptr || t == TYPE_OPEN_ARR || (ptr->getType() != expected
+                    && (const_vals.count(v->get_name() + ".len") == 0
+                        || elem != expected->getPointerElementType()
+                        ->getArrayElementType()))) {
+            std::cout << "call error: " << name << std::endl;
+            p.push_back(llvm::UndefValue::get(expected));
+            if (t == TYPE_OPEN_ARR)
+                p.push_back(llvm::UndefValue::get(
+                            llvm::Type::getInt64Ty(context)));
+            continue;
+        }
+        p.push_back(builder.CreateBitCast(ptr, expected));
+    }
+    return p;
+}
+
+int ast::intern(const std::string &name) {
+    return intern(name.data(), name.size(), yyhash(name.data(), name.size()));
+}
+
+int ast::intern(const char *s, size_t n, uint64_t hash) {
+    auto mask = symbol_slots.size() - 1;
+    auto i = hash & mask;
+    for (; symbol_slots[i] != -1; i = (i + 1) & mask) {
+        auto id = symbol_slots[i];
+        if (symbol_hashes[id] == hash && symbol_names[id].size() == n
+                && symbol_names[id].compare(0, n, s, n) == 0)
+            return id;
+    }
+    auto id = static_cast<int>(symbol_names.size());
+    symbol_names.emplace_back(s, n);
+    symbol_hashes.push_back(hash);
+    symbol_slots[i] = id;
+
+    /* keep table at most half full */
+    if (2 * symbol_names.size() > symbol_slots.size()) {
+        symbol_slots.assign(2 * symbol_slots.size(), -1);
+        mask = symbol_slots.size() - 1;
+        for (size_t k = 0; k < symbol_hashes.size(); ++k) {
+            auto j = symbol_hashes[k] & mask;
+            while (symbol_slots[j] != -1)
+                j = (j + 1) & mask;
+            symbol_slots[j] = k;
+        }
+    }
+    return id;
+}
+
+const std::string &ast::symbol_name(int id) {
+    return symbol_names[id];
+}
+
+/*
+ * arena class
+ */
+arena *arena::current = nullptr;
+
+/* nodes are small, block holds thousands of them */
+static const size_t ARENA_BLOCK = 1 << 16;
+
+/*
+ * Nodes are destroyed in reverse order of allocation, their members such
+ * as names and lists of children free own memory, children themselves
+ * are destroyed by arena too. Nodes elsewhere, as types owned by
+ * shared_ptr, are not.
+ */
+arena::~arena() {
+    for (auto n = nodes.rbegin(); n != nodes.rend(); ++n)
+        (*n)->~node();
+    for (auto b : blocks)
+        std::free(b);
+}
+
+void *arena::alloc(size_t n) {
+    auto align = alignof(std::max_align_t);
+    n = (n + align - 1) & ~(align - 1);
+    if (pos == nullptr || static_cast<size_t>(end - pos) < n) {
+        auto size = std::max(n, ARENA_BLOCK);
+        pos = static_cast<char *>(std::malloc(size));
+        end = pos + size;
+        blocks.push_back(pos);
+    }
+    auto p = pos;
+    pos += n;
+    bytes += n;
+    /* only operator new of node takes memory, node is constructed in it */
+    nodes.push_back(static_cast<node *>(static_cast<void *>(p)));
+    return p;
+}
+
+size_t arena::get_nodes() const {
+    return nodes.size();
+}
+
+size_t arena::get_bytes() const {
+    return bytes;
+}
+
+size_t arena::get_blocks() const {
+    return blocks.size();
+}
+
+/*
+ * compilation_unit class
+ */
+compilation_unit::compilation_unit() : prev{arena::current} {
+    arena::current = &nodes;
+}
+
+compilation_unit::~compilation_unit() {
+    arena::current = prev;
+}
+
+void compilation_unit::stats() const {
+    std::cerr << "nodes: " << nodes.get_nodes() << std::endl;
+    std::cerr << "arena bytes: " << nodes.get_bytes() << " in "
+        << nodes.get_blocks() << " blocks" << std::endl;
+}
 
 /*
  * abstract node class
  */
+node::node() {}
+
 node::~node() {}
 
+void *node::operator new(size_t n) {
+    if (arena::current == nullptr)
+        return ::operator new(n);
+    return arena::current->alloc(n);
+}
+
+/* memory is released with arena */
+void node::operator delete(void *) {}
+
 void node::print_spaces(int spaces) const {
     for (auto i = 0; i < spaces; ++i)
         std::cout << " ";
@@ -50,59 +1267,51 @@ decl::~decl() {}
 
 void decl::add_type(std::shared_ptr<type> t) {}
 
+/* only constants, procedures and functions are part of interface */
+void decl::interface(std::ostream &) const {}
+
 /*
  * decl_list class
  */
-decl_list::decl_list(decl *d, decl_list *l)
-    : declaration{d}, next{l} {}
-
-llvm::Value *decl_list::gen_ir() {
-    auto d = declaration->gen_ir();
-    next->gen_ir();
-    return d;
+void decl_list::add(decl *d) {
+    decls.push_back(d);
 }
 
-decl_list::~decl_list() {
-    delete declaration;
-    delete next;
+llvm::Value *decl_list::gen_ir() {
+    llvm::Value *r = nullptr;
+    for (size_t i = 0; i < decls.size(); ++i) {
+        auto v = decls[i]->gen_ir();
+        if (i == 0)
+            r = v;
+    }
+    return r;
 }
 
 void decl_list::dump(int s) const {
     print_spaces(s);
     std::cout << "decl_list" << std::endl;
-    declaration->dump(s + 4);
-    next->dump(s);
-}
-
-/*
- * null_decl_list class
- */
-null_decl_list::null_decl_list() : decl_list{nullptr, nullptr} {}
-
-llvm::Value *null_decl_list::gen_ir() {
-    return nullptr;
+    for (auto d : decls)
+        d->dump(s + 4);
 }
 
-void null_decl_list::dump(int s) const {
-    print_spaces(s);
-    std::cout << "null_decl_list" << std::endl;
+void decl_list::interface(std::ostream &out) const {
+    for (auto d : decls)
+        d->interface(out);
 }
 
 /*
  * var_decl_list class
  */
-var_decl_list::var_decl_list(decl *d, decl_list *l) : decl_list{d, l} {}
-
 void var_decl_list::add_type(std::shared_ptr<type> t) {
-    declaration->add_type(t);
-    next->add_type(t);
+    for (auto d : decls)
+        d->add_type(t);
 }
 
 void var_decl_list::dump(int s) const {
     print_spaces(s);
     std::cout << "var_decl_list" << std::endl;
-    declaration->dump(s + 4);
-    next->dump(s);
+    for (auto d : decls)
+        d->dump(s + 4);
 }
 
 /*
@@ -110,11 +1319,6 @@ void var_decl_list::dump(int s) const {
  */
 block::block(decl_list *d, stmt *s) : decls{d}, body{s} {}
 
-block::~block() {
-    delete decls;
-    delete body;
-}
-
 llvm::Value *block::gen_ir() {
     decls->gen_ir();
     return body->gen_ir();
@@ -132,14 +1336,24 @@ void block::dump(int s) const {
  */
 expr::~expr() {}
 
+var_access *expr::as_var_access() {
+    return nullptr;
+}
+
+void expr::deps(loop_info &l) const {}
+
+bool expr::affine_form(const std::string &index, affine &a) const {
+    return false;
+}
+
 /*
  * binary class
  */
 binary_expr::binary_expr(expr *l, expr *r) : left{l}, right{r} {}
 
-binary_expr::~binary_expr() {
-    delete left;
-    delete right;
+void binary_expr::deps(loop_info &l) const {
+    left->deps(l);
+    right->deps(l);
 }
 
 /*
@@ -152,6 +1366,8 @@ llvm::Value *eq_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFCmpOEQ(l, r, "eq");
     return builder.CreateICmpEQ(l, r, "eq");
 }
 
@@ -172,6 +1388,8 @@ llvm::Value *ne_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFCmpUNE(l, r, "ne");
     return builder.CreateICmpNE(l, r, "ne");
 }
 
@@ -192,6 +1410,8 @@ llvm::Value *lt_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFCmpOLT(l, r, "lt");
     return builder.CreateICmpSLT(l, r, "lt");
 }
 
@@ -212,6 +1432,8 @@ llvm::Value *gt_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFCmpOGT(l, r, "gt");
     return builder.CreateICmpSGT(l, r, "gt");
 }
 
@@ -232,6 +1454,8 @@ llvm::Value *le_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFCmpOLE(l, r, "le");
     return builder.CreateICmpSLE(l, r, "le");
 }
 
@@ -252,6 +1476,8 @@ llvm::Value *ge_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFCmpOGE(l, r, "ge");
     return builder.CreateICmpSGE(l, r, "ge");
 }
 
@@ -272,9 +1498,19 @@ llvm::Value *add_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFAdd(l, r, "add");
     return builder.CreateAdd(l, r, "add");
 }
 
+bool add_expr::affine_form(const std::string &index, affine &a) const {
+    auto r = affine{0, {}, 0};
+    if (!left->affine_form(index, a) || !right->affine_form(index, r))
+        return false;
+    a = affine_add(a, r, 1);
+    return true;
+}
+
 void add_expr::dump(int s) const {
     print_spaces(s);
     std::cout << "add_expr" << std::endl;
@@ -292,9 +1528,19 @@ llvm::Value *sub_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFSub(l, r, "sub");
     return builder.CreateNSWSub(l, r, "sub");
 }
 
+bool sub_expr::affine_form(const std::string &index, affine &a) const {
+    auto r = affine{0, {}, 0};
+    if (!left->affine_form(index, a) || !right->affine_form(index, r))
+        return false;
+    a = affine_add(a, r, -1);
+    return true;
+}
+
 void sub_expr::dump(int s) const {
     print_spaces(s);
     std::cout << "sub_expr" << std::endl;
@@ -312,6 +1558,10 @@ llvm::Value *or_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r)) {
+        std::cout << "or error" << std::endl;
+        return nullptr;
+    }
     return builder.CreateOr(l, r, "or");
 }
 
@@ -332,9 +1582,24 @@ llvm::Value *mul_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r))
+        return builder.CreateFMul(l, r, "mul");
     return builder.CreateMul(l, r, "mul");
 }
 
+bool mul_expr::affine_form(const std::string &index, affine &a) const {
+    auto r = affine{0, {}, 0};
+    if (!left->affine_form(index, a) || !right->affine_form(index, r))
+        return false;
+    if (affine_const(a))
+        a = affine_scale(r, a.k);
+    else if (affine_const(r))
+        a = affine_scale(a, r.k);
+    else
+        return false;
+    return true;
+}
+
 void mul_expr::dump(int s) const {
     print_spaces(s);
     std::cout << "mul_expr" << std::endl;
@@ -352,6 +1617,10 @@ llvm::Value *div_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r)) {
+        std::cout << "div error" << std::endl;
+        return nullptr;
+    }
     return builder.CreateSDiv(l, r, "div");
 }
 
@@ -362,6 +1631,27 @@ void div_expr::dump(int s) const {
     right->dump(s + 4);
 }
 
+/*
+ * real_div_expr class
+ * Operator / divides as reals whatever types of operands are.
+ */
+real_div_expr::real_div_expr(expr *l, expr *r) : binary_expr{l, r} {}
+
+llvm::Value *real_div_expr::gen_ir() {
+    auto l = left->gen_ir();
+    auto r = right->gen_ir();
+    if (l == nullptr || r == nullptr)
+        return nullptr;
+    return builder.CreateFDiv(to_real(l), to_real(r), "rdiv");
+}
+
+void real_div_expr::dump(int s) const {
+    print_spaces(s);
+    std::cout << "real_div_expr" << std::endl;
+    left->dump(s + 4);
+    right->dump(s + 4);
+}
+
 /*
  * mod_expr class
  */
@@ -372,6 +1662,10 @@ llvm::Value *mod_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r)) {
+        std::cout << "mod error" << std::endl;
+        return nullptr;
+    }
     return builder.CreateSRem(l, r, "mod");
 }
 
@@ -392,6 +1686,10 @@ llvm::Value *and_expr::gen_ir() {
     auto r = right->gen_ir();
     if (l == nullptr || r == nullptr)
         return nullptr;
+    if (promote(l, r)) {
+        std::cout << "and error" << std::endl;
+        return nullptr;
+    }
     return builder.CreateAnd(l, r, "and");
 }
 
@@ -422,8 +1720,8 @@ void exp_expr::dump(int s) const {
  * unary_expr class
  */
 unary_expr::unary_expr(expr *c) : child{c} {}
-unary_expr::~unary_expr() {
-    delete child;
+void unary_expr::deps(loop_info &l) const {
+    child->deps(l);
 }
 
 /*
@@ -437,10 +1735,19 @@ void minus_expr::dump(int s) const {
     child->dump(s + 4);
 }
 
+bool minus_expr::affine_form(const std::string &index, affine &a) const {
+    if (!child->affine_form(index, a))
+        return false;
+    a = affine_scale(a, -1);
+    return true;
+}
+
 llvm::Value *minus_expr::gen_ir() {
     auto c = child->gen_ir();
     if (c == nullptr)
         return nullptr;
+    if (c->getType()->isDoubleTy())
+        return builder.CreateFNeg(c, "minus");
     return builder.CreateNeg(c, "minus");
 }
 
@@ -453,6 +1760,10 @@ llvm::Value *not_expr::gen_ir() {
     auto c = child->gen_ir();
     if (c == nullptr)
         return nullptr;
+    if (c->getType()->isDoubleTy()) {
+        std::cout << "not error" << std::endl;
+        return nullptr;
+    }
     return builder.CreateNot(c, "not");
 }
 
@@ -476,15 +1787,21 @@ void null_expr::dump(int s) const {
 proc_call::proc_call(const std::string &n, std::list<expr *> p)
     : name{n}, params{std::move(p)} {}
 
-proc_call::~proc_call() {
-    for (auto e : params)
-        delete e; } 
 llvm::Value *proc_call::gen_ir() {
+    auto b = builtin_fun(name);
+    if (b != nullptr)
+        return call_builtin(name, b, params);
+    if (lowered_builtin(name))
+        return name == "fill" ? gen_fill(params) : gen_copy(params);
+    if (io_builtin(name))
+        return gen_io_builtin(name, params);
     auto fun = module->getFunction(name);
-    auto p = std::vector<llvm::Value *>{};
-    for (auto e : params)
-        p.push_back(e->gen_ir());
-    return builder.CreateCall(fun, p);
+    return builder.CreateCall(fun, gen_args(fun, name, params));
+}
+
+void proc_call::deps(loop_info &l) const {
+    if (!builtin_deps(l, name, params))
+        l.fail("calls " + name);
 }
 
 void proc_call::dump(int s) const {
@@ -500,52 +1817,108 @@ void proc_call::dump(int s) const {
 call::call(const std::string &n, std::list<expr *> p)
     : name{n}, params{std::move(p)} {}
 
-call::~call() {
+llvm::Value *call::gen_ir() {
+    auto b = builtin_fun(name);
+    if (b != nullptr)
+        return call_builtin(name, b, params);
+    if (conversion(name))
+        return gen_conversion(name, params);
+    if (io_builtin(name))
+        return gen_io_builtin(name, params);
+    auto fun = module->getFunction(name);
+    return builder.CreateCall(fun, gen_args(fun, name, params), "call");
+}
+
+void call::deps(loop_info &l) const {
+    if (!builtin_deps(l, name, params))
+        l.fail("calls " + name);
+}
+
+void call::dump(int s) const {
+    print_spaces(s);
+    std::cout << "call name: " << name << std::endl;
     for (auto e : params)
-        delete e;
+        e->dump(s + 4);
+}
+
+/*
+ * var_access class
+ */
+var_access::var_access(const std::string &n) : name{n}, id{intern(n)} {}
+
+void var_access::add_idx(expr *e) {
+    idxs.push_back(e);
+}
+
+std::string var_access::get_name() const {
+    return name;
+}
+
+/*
+ * address of whole array, nullptr for scalars and indexed access
+ */
+llvm::Value *var_access::array_ref() const {
+    if (!idxs.empty() || !is_array(name))
+        return nullptr;
+    return const_vals.get(id);
 }
 
-llvm::Value *call::gen_ir() {
-    auto fun = module->getFunction(name);
-    auto p = std::vector<llvm::Value *>{};
-    for (auto e : params)
-        p.push_back(e->gen_ir());
-    return builder.CreateCall(fun, p, "call");
+var_access *var_access::as_var_access() {
+    return this;
 }
 
-void call::dump(int s) const {
-    print_spaces(s);
-    std::cout << "call name: " << name << std::endl;
-    for (auto e : params)
-        e->dump(s + 4);
+/*
+ * address of variable or of its element when indexed
+ */
+llvm::Value *var_access::get_ptr() {
+    if (idxs.empty())
+        return const_vals.get(id);
+    if (is_packed(name)) {
+        std::cout << "packed error: " << name << std::endl;
+        return llvm::UndefValue::get(llvm::Type::getInt64PtrTy(context));
+    }
+    return array_elem(name, gen_idxs(idxs));
 }
 
 /*
- * var_access class
+ * eof without variable of that name tests end of standard input
  */
-var_access::var_access(const std::string &n) : name{n} {}
+static bool is_eof(const std::string &name) {
+    return name == "eof" && const_vals.count(name) == 0
+        && module->getFunction(name) == nullptr;
+}
 
-var_access::~var_access() {
-    for (auto e : idxs)
-        delete e;
+llvm::Value *var_access::gen_ir() {
+    if (idxs.empty() && is_eof(name))
+        return builder.CreateICmpNE(builder.CreateCall(eof_fun,
+                    std::vector<llvm::Value *>{}),
+                llvm::ConstantInt::get(context, llvm::APInt(64, 0)), "eof");
+    if (!idxs.empty() && is_packed(name))
+        return load_bit(name, gen_idxs(idxs));
+    return load_elem(name, get_ptr());
 }
 
-void var_access::add_idx(expr *e) {
-    idxs.push_back(e);
+void var_access::deps(loop_info &l) const {
+    for (auto e : idxs)
+        e->deps(l);
+    if (!idxs.empty())
+        l.arrays.push_back(make_access(l, name, idxs, false));
+    else if (is_array(name))
+        l.arrays.push_back(access{name, {}, false, false});
+    else if (is_eof(name))
+        l.forbid("performs input or output");
+    else
+        l.read(name);
 }
 
-llvm::Value *var_access::gen_ir() {
-    auto var = const_vals[name];
-    if (!idxs.empty()) {
-        auto pos = builder.CreateAdd(idxs.front()->gen_ir(), llvm::ConstantInt::get(llvm::IntegerType::getInt64Ty(context), arr_starts[name]));
-        auto index = builder.CreateInBoundsGEP(
-                var,
-                { llvm::ConstantInt::get(llvm::IntegerType::getInt64Ty(context), 0),
-                  pos }
-                );
-        return builder.CreateLoad(index);
-    }
-    return builder.CreateLoad(var, name.c_str());
+bool var_access::affine_form(const std::string &index, affine &a) const {
+    if (!idxs.empty())
+        return false;
+    if (name == index)
+        a = affine{1, {}, 0};
+    else
+        a = affine{0, {{name, 1}}, 0};
+    return true;
 }
 
 void var_access::dump(int s) const {
@@ -558,12 +1931,7 @@ void var_access::dump(int s) const {
 /*
  * var_assign class
  */
-var_assign::var_assign(const std::string &n) : name{n} {}
-
-var_assign::~var_assign() {
-    for (auto e : idxs)
-        delete e;
-}
+var_assign::var_assign(const std::string &n) : name{n}, id{intern(n)} {}
 
 std::string var_assign::get_name() const {
     return name;
@@ -573,14 +1941,67 @@ void var_assign::add_idx(expr *e) {
     idxs.push_back(e);
 }
 
-llvm::Value *var_assign::get_idx() const {
+/*
+ * address of variable or of its element when indexed
+ */
+llvm::Value *var_assign::get_ptr() {
     if (idxs.empty())
-        return nullptr; 
-    return idxs.front()->gen_ir();
+        return named_vals.get(id);
+    if (is_packed(name)) {
+        std::cout << "packed error: " << name << std::endl;
+        return llvm::UndefValue::get(llvm::Type::getInt64PtrTy(context));
+    }
+    return array_elem(name, gen_idxs(idxs));
+}
+
+/*
+ * whole array assigned to, null for scalar or element
+ */
+llvm::Value *var_assign::array_ref() const {
+    if (!idxs.empty() || !is_array(name))
+        return nullptr;
+    return named_vals.get(id);
+}
+
+bool var_assign::is_real() const {
+    return var_types.count(id) != 0 && var_types.get(id)->is_real();
+}
+
+/*
+ * store to variable or array element, also to bit of packed array
+ */
+llvm::Value *var_assign::store(llvm::Value *v) {
+    if (!idxs.empty() && is_packed(name))
+        return store_bit(name, gen_idxs(idxs), v);
+    return store_elem(v, get_ptr());
+}
+
+/*
+ * record write of variable, update also reads it first (inc, dec)
+ */
+void var_assign::deps(loop_info &l, bool update) const {
+    for (auto e : idxs)
+        e->deps(l);
+    /* elements of packed array share words */
+    if (!idxs.empty() && is_packed(name)) {
+        l.fail("writes packed array " + name);
+        return;
+    }
+    if (!idxs.empty()) {
+        l.arrays.push_back(make_access(l, name, idxs, true));
+        return;
+    }
+    if (is_array(name)) {
+        l.arrays.push_back(access{name, {}, false, true});
+        return;
+    }
+    if (update)
+        l.read(name);
+    l.write(name);
 }
 
 llvm::Value *var_assign::gen_ir() {
-    return named_vals[name];
+    return named_vals.get(id);
 }
 
 void var_assign::dump(int s) const {
@@ -595,6 +2016,11 @@ void var_assign::dump(int s) const {
  */
 numb::numb(long int v) : val{v} {}
 
+bool numb::affine_form(const std::string &index, affine &a) const {
+    a = affine{0, {}, val};
+    return true;
+}
+
 llvm::Value *numb::gen_ir() {
     return llvm::ConstantInt::getSigned(llvm::IntegerType::getInt64Ty(context), val);
 }
@@ -605,61 +2031,86 @@ void numb::dump(int s) const {
 }
 
 /*
- * stmt class
+ * real_numb class
  */
-stmt::~stmt() {}
+real_numb::real_numb(double v) : val{v} {}
 
-void stmt::dump(int s) const {
+llvm::Value *real_numb::gen_ir() {
+    return llvm::ConstantFP::get(llvm::Type::getDoubleTy(context), val);
+}
+
+void real_numb::dump(int s) const {
     print_spaces(s);
-    std::cout << "stmt" << std::endl;
+    std::cout << "real_numb: " << val << std::endl;
 }
 
 /*
- * stmt_list class
+ * bool_const class
  */
-stmt_list::stmt_list(stmt* s, stmt_list* l) : statement{s}, next{l} {}
+bool_const::bool_const(bool v) : val{v} {}
 
-stmt_list::~stmt_list() {
-    delete statement;
-    delete next;
+llvm::Value *bool_const::gen_ir() {
+    return builder.getInt1(val);
 }
 
-llvm::Value *stmt_list::gen_ir() {
-    auto s = statement->gen_ir();
-    next->gen_ir();
-    return s;
+void bool_const::dump(int s) const {
+    print_spaces(s);
+    std::cout << "bool_const: " << (val ? "true" : "false") << std::endl;
 }
 
-void stmt_list::dump(int s) const {
+/*
+ * stmt class
+ */
+stmt::~stmt() {}
+
+void stmt::deps(loop_info &l) const {
+    l.fail("unsupported statement");
+}
+
+void stmt::dump(int s) const {
     print_spaces(s);
-    std::cout << "stmt_list" << std::endl;
-    statement->dump(s + 4);
-    next->dump(s);
+    std::cout << "stmt" << std::endl;
 }
 
 /*
- * null_stmt_list class
+ * stmt_list class
  */
-null_stmt_list::null_stmt_list() : stmt_list{nullptr, nullptr} {}
+void stmt_list::add(stmt *s) {
+    stmts.push_back(s);
+}
 
-llvm::Value *null_stmt_list::gen_ir() {
-    return nullptr;
+llvm::Value *stmt_list::gen_ir() {
+    llvm::Value *r = nullptr;
+    for (size_t i = 0; i < stmts.size(); ++i) {
+        auto v = stmts[i]->gen_ir();
+        if (i == 0)
+            r = v;
+    }
+    return r;
+}
+
+void stmt_list::deps(loop_info &l) const {
+    for (auto s : stmts)
+        s->deps(l);
 }
-void null_stmt_list::dump(int s) const {
+
+void stmt_list::dump(int s) const {
     print_spaces(s);
-    std::cout << "null_stmt_list" << std::endl;
+    std::cout << "stmt_list" << std::endl;
+    for (auto e : stmts)
+        e->dump(s + 4);
 }
 
 /*
  * const_decl class
  */
-const_decl::const_decl(const std::string& n, int v) : name{n}, val{v} {}
+const_decl::const_decl(const std::string& n, long int v) : name{n}, val{v} {}
 
 llvm::Value *const_decl::gen_ir() {
     if (const_vals.count(name) != 0)
         return nullptr;
     auto a = builder.CreateAlloca(llvm::Type::getInt64Ty(context), 0, name.c_str());
-    const_vals[name] = a;
+    const_vals.set(name, a);
     auto v = llvm::ConstantInt::getSigned(llvm::IntegerType::getInt64Ty(context), val);
     builder.CreateStore(v, a);
     return a;
@@ -670,6 +2121,10 @@ void const_decl::dump(int s) const {
     std::cout << "const_decl name: " << name << " val: " << val << std::endl;
 }
 
+void const_decl::interface(std::ostream &out) const {
+    out << "const " << name << " = " << val << ";" << std::endl;
+}
+
 /*
  * var_decl class
  */
@@ -679,21 +2134,52 @@ void var_decl::add_type(std::shared_ptr<type> t) {
     var_type = t;
 }
 
+/*
+ * Small arrays live on stack. Large arrays of program are zero initialised
+ * static storage, large arrays of procedures and functions are allocated
+ * by runtime and released before return.
+ */
 llvm::Value *var_decl::gen_ir() {
     if (named_vals.count(name) != 0)
         return nullptr;
-    llvm::AllocaInst *a = nullptr;
-    if (var_type->get_type() == TYPE_INT) {
-        a = builder.CreateAlloca(llvm::Type::getInt64Ty(context),
-                nullptr, name.c_str());
-    } else if (var_type->get_type() == TYPE_ARR) {
-        a = builder.CreateAlloca(llvm::ArrayType::get(
-                    llvm::Type::getInt64Ty(context), var_type->get_size()
-                    ), nullptr, name.c_str());
-        arr_starts[name] = -var_type->get_from();
-    }
-    named_vals[name] = a;
-    const_vals[name] = a;
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto fun = builder.GetInsertBlock()->getParent();
+    llvm::Value *a = nullptr;
+    if (is_scalar(var_type->get_type())) {
+        a = builder.CreateAlloca(scalar_type(*var_type), nullptr, name.c_str());
+    } else if (var_type->get_type() == TYPE_ARR
+            || var_type->get_type() == TYPE_PACKED) {
+        auto t = llvm::ArrayType::get(elem_type(*var_type),
+                var_type->get_size());
+        auto bytes = module->getDataLayout().getTypeAllocSize(t);
+        if (bytes <= STACK_ARRAY_MAX) {
+            a = builder.CreateAlloca(t, nullptr, name.c_str());
+        } else if (fun->getName() == "main") {
+            auto g = new llvm::GlobalVariable(*module, t, false,
+                    llvm::GlobalValue::InternalLinkage,
+                    llvm::ConstantAggregateZero::get(t), name);
+            g->setAlignment(ARRAY_ALIGN);
+            a = g;
+            if (hugepages)
+                builder.CreateCall(hugepages_fun, std::vector<llvm::Value *>{
+                        builder.CreateBitCast(a,
+                                llvm::Type::getInt8PtrTy(context)),
+                        llvm::ConstantInt::get(i64, bytes)});
+        } else {
+            auto p = builder.CreateCall(alloc_array_fun,
+                    std::vector<llvm::Value *>{
+                    llvm::ConstantInt::get(i64, bytes),
+                    llvm::ConstantInt::get(i64, hugepages)});
+            a = builder.CreateBitCast(p, t->getPointerTo(), name.c_str());
+            heap_arrays.push_back(std::make_pair(a, bytes));
+        }
+    } else {
+        std::cout << "var_decl error: " << name << std::endl;
+        return nullptr;
+    }
+    var_types.set(name, var_type);
+    named_vals.set(name, a);
+    const_vals.set(name, a);
     return a;
 }
 
@@ -710,95 +2196,287 @@ type::~type() {}
 
 llvm::Value *type::gen_ir() { return nullptr; }
 
+std::vector<std::pair<long int, long int>> type::get_bounds() const {
+    return std::vector<std::pair<long int, long int>>{};
+}
+
+int type::get_bits() const {
+    return 64;
+}
+
+bool type::is_signed() const {
+    return true;
+}
+
+bool type::is_real() const {
+    return false;
+}
+
+/*
+ * real_type class
+ */
+int real_type::get_type() const {
+    return TYPE_REAL;
+}
+
+long int real_type::get_size() const {
+    return 0;
+}
+
+long int real_type::get_from() const {
+    return 0;
+}
+
+bool real_type::is_real() const {
+    return true;
+}
+
+void real_type::dump(int s) const {
+    print_spaces(s);
+    std::cout << "real_type" << std::endl;
+}
+
+void real_type::print(std::ostream &out) const {
+    out << "real";
+}
+
 /*
  * int_type class
  */
+int_type::int_type(int b, bool s) : bits{b}, sign{s} {}
+
 int int_type::get_type() const {
     return TYPE_INT;
 }
 
-int int_type::get_size() const {
+long int int_type::get_size() const {
+    return 0;
+}
+
+long int int_type::get_from() const {
+    return 0;
+}
+
+int int_type::get_bits() const {
+    return bits;
+}
+
+bool int_type::is_signed() const {
+    return sign;
+}
+
+/*
+ * bool_type class
+ */
+int bool_type::get_type() const {
+    return TYPE_BOOL;
+}
+
+long int bool_type::get_size() const {
     return 0;
 }
 
-int int_type::get_from() const {
+long int bool_type::get_from() const {
     return 0;
 }
 
+int bool_type::get_bits() const {
+    return 1;
+}
+
+bool bool_type::is_signed() const {
+    return false;
+}
+
+void bool_type::dump(int s) const {
+    print_spaces(s);
+    std::cout << "bool_type" << std::endl;
+}
+
+void bool_type::print(std::ostream &out) const {
+    out << "boolean";
+}
+
 void int_type::dump(int s) const {
     print_spaces(s);
-    std::cout << "int_type" << std::endl;
+    std::cout << "int_type bits: " << bits << (sign ? "" : " unsigned")
+        << std::endl;
+}
+
+void int_type::print(std::ostream &out) const {
+    switch (bits) {
+        case 32:
+            out << "longint";
+            break;
+        case 16:
+            out << (sign ? "smallint" : "word");
+            break;
+        case 8:
+            out << (sign ? "shortint" : "byte");
+            break;
+        default:
+            out << "integer";
+    }
 }
 
 /*
  * array_type class
  */
-array_type::array_type(int f, int t) : from{f}, to{t} {}
+array_type::array_type(std::vector<std::pair<long int, long int>> b,
+        std::shared_ptr<type> e) : bounds{std::move(b)}, elem{std::move(e)} {}
 
 int array_type::get_type() const {
     return TYPE_ARR;
 }
 
-int array_type::get_size() const {
-    return to - from + 1;
+long int array_type::get_size() const {
+    auto size = 1L;
+    for (auto &b : bounds)
+        size *= b.second - b.first + 1;
+    return size;
 }
 
-int array_type::get_from() const {
-    return from;
+long int array_type::get_from() const {
+    return bounds.front().first;
+}
+
+std::vector<std::pair<long int, long int>> array_type::get_bounds() const {
+    return bounds;
+}
+
+int array_type::get_bits() const {
+    return elem->get_bits();
+}
+
+bool array_type::is_signed() const {
+    return elem->is_signed();
+}
+
+bool array_type::is_real() const {
+    return elem->is_real();
 }
 
 void array_type::dump(int s) const {
     print_spaces(s);
-    std::cout << "array_type" << std::endl;
+    std::cout << "array_type";
+    for (auto &b : bounds)
+        std::cout << " " << b.first << ".." << b.second;
+    std::cout << std::endl;
+    elem->dump(s + 4);
+}
+
+void array_type::print(std::ostream &out) const {
+    out << "array [";
+    for (auto &b : bounds)
+        out << (&b == &bounds.front() ? "" : ", ") << b.first << " .. "
+            << b.second;
+    out << "] of ";
+    elem->print(out);
+}
+
+/*
+ * open_array_type class
+ */
+open_array_type::open_array_type(std::shared_ptr<type> e)
+    : array_type{std::vector<std::pair<long int, long int>>{{0, -1}},
+        std::move(e)} {}
+
+int open_array_type::get_type() const {
+    return TYPE_OPEN_ARR;
+}
+
+void open_array_type::dump(int s) const {
+    print_spaces(s);
+    std::cout << "open_array_type" << std::endl;
+    elem->dump(s + 4);
+}
+
+void open_array_type::print(std::ostream &out) const {
+    out << "array of ";
+    elem->print(out);
+}
+
+/*
+ * packed_array_type class
+ */
+packed_array_type::packed_array_type(
+        std::vector<std::pair<long int, long int>> b)
+    : array_type{std::move(b), std::make_shared<bool_type>()} {}
+
+int packed_array_type::get_type() const {
+    return TYPE_PACKED;
+}
+
+/*
+ * number of 64-bit words
+ */
+long int packed_array_type::get_size() const {
+    return (get_length() + 63) / 64;
+}
+
+int packed_array_type::get_bits() const {
+    return 64;
+}
+
+/*
+ * number of elements
+ */
+long int packed_array_type::get_length() const {
+    return array_type::get_size();
+}
+
+void packed_array_type::dump(int s) const {
+    print_spaces(s);
+    std::cout << "packed_array_type";
+    for (auto &b : bounds)
+        std::cout << " " << b.first << ".." << b.second;
+    std::cout << std::endl;
+}
+
+void packed_array_type::print(std::ostream &out) const {
+    out << "packed ";
+    array_type::print(out);
 }
 
 /*
  * proc_decl class
  */
-proc_decl::proc_decl(const std::string &n, std::list<std::string> a, block *b)
+proc_decl::proc_decl(const std::string &n, std::list<param> a, block *b)
     : name{n}, args{std::move(a)}, body{b} {}
 
 llvm::Value *proc_decl::gen_ir() {
     auto prev_bb = builder.GetInsertBlock();
 
-    auto fun = module->getFunction(name);
-    if (fun == nullptr) {
-        auto arguments = std::vector<llvm::Type *>(args.size(), llvm::Type::getInt64Ty(context));
-        auto fun_type = llvm::FunctionType::get(llvm::Type::getVoidTy(context), arguments, false);
-        fun = llvm::Function::Create(fun_type, llvm::Function::ExternalLinkage, name, module.get());
-        auto it = args.begin();
-        for (auto &arg : fun->args())
-            arg.setName(*(it++));
-    }
+    auto fun = declare_fun(name, llvm::Type::getVoidTy(context), args);
 
     if (body != nullptr) {
-        auto backup_named = std::map<std::string, llvm::AllocaInst *>(named_vals);
-        auto backup_const = std::map<std::string, llvm::AllocaInst *>(const_vals);
-        auto backup_arr = std::map<std::string, long int>(arr_starts);
-        named_vals.clear();
-        const_vals.clear();
-        arr_starts.clear();
+        auto backup_group = spawn_group;
+        auto backup_heap = heap_arrays;
+        named_vals.push();
+        const_vals.push();
+        var_types.push();
+        spawn_group = nullptr;
+        heap_arrays.clear();
 
         auto bb = llvm::BasicBlock::Create(context, "entry", fun);
         builder.SetInsertPoint(bb);
 
         auto a = builder.CreateAlloca(llvm::Type::getInt64Ty(context), nullptr, name.c_str());
-        named_vals[name] = a;
-        const_vals[name] = a;
-        for (auto &arg : fun->args()) {
-            a = builder.CreateAlloca(llvm::Type::getInt64Ty(context), nullptr, arg.getName());
-            builder.CreateStore(&arg, a);
-            named_vals[arg.getName()] = a;
-            const_vals[arg.getName()] = a;
-        }
+        named_vals.set(name, a);
+        const_vals.set(name, a);
+        bind_params(fun, args);
 
         body->gen_ir();
         builder.CreateRetVoid();
+        sync_spawned(fun);
+        free_arrays(fun);
         verifyFunction(*fun);
 
-        named_vals = backup_named;
-        const_vals = backup_const;
-        arr_starts = backup_arr;
+        named_vals.pop();
+        const_vals.pop();
+        var_types.pop();
+        spawn_group = backup_group;
+        heap_arrays = backup_heap;
     }
 
     builder.SetInsertPoint(prev_bb);
@@ -810,7 +2488,7 @@ void proc_decl::dump(int s) const {
     print_spaces(s);
     std::cout << "proc_decl name: " << name << " args:";
     for (auto &a : args)
-        std::cout << " " << a;
+        std::cout << " " << a.name;
     std::cout << std::endl;
     if (body != nullptr) {
         body->dump(s + 4);
@@ -820,54 +2498,54 @@ void proc_decl::dump(int s) const {
     }
 }
 
+void proc_decl::interface(std::ostream &out) const {
+    out << "procedure " << name;
+    print_params(out, args);
+    out << "; forward;" << std::endl;
+}
+
 /*
  * func_decl class
  */
-func_decl::func_decl(const std::string &n, std::list<std::string> a, block *b)
-    : name{n}, args{std::move(a)}, body{b} {}
+func_decl::func_decl(const std::string &n, std::list<param> a,
+        std::shared_ptr<type> t, block *b)
+    : name{n}, args{std::move(a)}, ret_type{std::move(t)}, body{b} {}
 
 llvm::Value *func_decl::gen_ir() {
     auto prev_bb = builder.GetInsertBlock();
 
-    auto fun = module->getFunction(name);
-    if (fun == nullptr) {
-        auto arguments = std::vector<llvm::Type *>(args.size(), llvm::Type::getInt64Ty(context));
-        auto fun_type = llvm::FunctionType::get( llvm::Type::getInt64Ty(context), arguments, false);
-        fun = llvm::Function::Create(fun_type, llvm::Function::ExternalLinkage, name, module.get());
-        auto it = args.begin();
-        for (auto &arg : fun->args())
-            arg.setName(*(it++));
-    }
+    auto fun = declare_fun(name, scalar_type(*ret_type), args);
 
     if (body != nullptr) {
-        auto backup_named = std::map<std::string, llvm::AllocaInst *>(named_vals);
-        auto backup_const = std::map<std::string, llvm::AllocaInst *>(const_vals);
-        auto backup_arr = std::map<std::string, long int>(arr_starts);
-        named_vals.clear();
-        const_vals.clear();
-        arr_starts.clear();
+        auto backup_group = spawn_group;
+        auto backup_heap = heap_arrays;
+        named_vals.push();
+        const_vals.push();
+        var_types.push();
+        spawn_group = nullptr;
+        heap_arrays.clear();
 
         auto bb = llvm::BasicBlock::Create(context, "entry", fun);
         builder.SetInsertPoint(bb);
 
-        auto a = builder.CreateAlloca(llvm::Type::getInt64Ty(context), nullptr, name.c_str());
-        named_vals[name] = a;
-        const_vals[name] = a;
-        for (auto &arg : fun->args()) {
-            a = builder.CreateAlloca(llvm::Type::getInt64Ty(context), nullptr, arg.getName());
-            builder.CreateStore(&arg, a);
-            named_vals[arg.getName()] = a;
-            const_vals[arg.getName()] = a;
-        }
+        auto a = builder.CreateAlloca(fun->getReturnType(), nullptr, name.c_str());
+        named_vals.set(name, a);
+        const_vals.set(name, a);
+        var_types.set(name, ret_type);
+        bind_params(fun, args);
 
         body->gen_ir();
-        auto ret_val = builder.CreateLoad(named_vals[name], name.c_str());
+        auto ret_val = builder.CreateLoad(named_vals.get(name), name.c_str());
         builder.CreateRet(ret_val);
+        sync_spawned(fun);
+        free_arrays(fun);
         verifyFunction(*fun);
 
-        named_vals = backup_named;
-        const_vals = backup_const;
-        arr_starts = backup_arr;
+        named_vals.pop();
+        const_vals.pop();
+        var_types.pop();
+        spawn_group = backup_group;
+        heap_arrays = backup_heap;
     }
 
     builder.SetInsertPoint(prev_bb);
@@ -879,7 +2557,7 @@ void func_decl::dump(int s) const {
     print_spaces(s);
     std::cout << "func_decl name: " << name << " args:";
     for (auto &a : args)
-        std::cout << " " << a;
+        std::cout << " " << a.name;
     std::cout << std::endl;
     if (body != nullptr) {
         body->dump(s + 4);
@@ -889,19 +2567,27 @@ void func_decl::dump(int s) const {
     }
 }
 
+void func_decl::interface(std::ostream &out) const {
+    out << "function " << name;
+    print_params(out, args);
+    out << " : ";
+    ret_type->print(out);
+    out << "; forward;" << std::endl;
+}
+
 /*
  * compound_stmt class
  */
 compound_stmt::compound_stmt(stmt_list *l) : list{l} {}
 
-compound_stmt::~compound_stmt() {
-    delete list;
-}
-
 llvm::Value *compound_stmt::gen_ir() {
     return list->gen_ir();
 }
 
+void compound_stmt::deps(loop_info &l) const {
+    list->deps(l);
+}
+
 void compound_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "compound_stmt" << std::endl;
@@ -913,26 +2599,47 @@ void compound_stmt::dump(int s) const {
  */
 assign_stmt::assign_stmt(var_assign *v , expr *e) : var{v}, expression{e} {}
 
-assign_stmt::~assign_stmt() {
-    delete var;
-    delete expression;
-}
-
 llvm::Value *assign_stmt::gen_ir() {
-    auto variable = var->gen_ir();
-    auto e = expression->gen_ir();
-    auto index = var->get_idx();
-    if (index == nullptr) {
-        builder.CreateStore(e, variable);
-    } else {
-        auto pos = builder.CreateAdd(index, llvm::ConstantInt::get(llvm::IntegerType::getInt64Ty(context), arr_starts[var->get_name()]));
-        auto position = builder.CreateInBoundsGEP(variable,
-                {llvm::ConstantInt::get(llvm::IntegerType::getInt64Ty(context), 0), pos});
-        builder.CreateStore(e, position);
+    auto dst = var->array_ref();
+    auto v = expression->as_var_access();
+    auto src = v == nullptr ? nullptr : v->array_ref();
+
+    /* whole array is copied by memcpy, open array may be shorter */
+    if (dst != nullptr || src != nullptr) {
+        if (dst == nullptr || src == nullptr
+                || dst->getType()->getPointerElementType()->getArrayElementType()
+                != src->getType()->getPointerElementType()->getArrayElementType()
+                || var_types.get(var->get_name())->is_signed()
+                != var_types.get(v->get_name())->is_signed()) {
+            std::cout << "assign error: " << var->get_name() << std::endl;
+            return nullptr;
+        }
+        if (dst == src)
+            return dst;
+        auto a = array_len(var->get_name());
+        auto b = array_len(v->get_name());
+        /* static lengths must agree, only open array is checked at run time */
+        if (llvm::isa<llvm::ConstantInt>(a) && llvm::isa<llvm::ConstantInt>(b)
+                && a != b) {
+            std::cout << "assign error: " << var->get_name() << std::endl;
+            return nullptr;
+        }
+        auto len = builder.CreateSelect(builder.CreateICmpSLT(a, b), a, b);
+        return builder.CreateMemCpy(dst, src, array_bytes(src, len), 8);
     }
+
+    auto e = expression->gen_ir();
+    if (e == nullptr)
+        return nullptr;
+    var->store(e);
     return e;
 }
 
+void assign_stmt::deps(loop_info &l) const {
+    expression->deps(l);
+    var->deps(l, false);
+}
+
 void assign_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "assign_stmt" << std::endl;
@@ -946,14 +2653,8 @@ void assign_stmt::dump(int s) const {
 if_stmt::if_stmt(expr *c, stmt *t, stmt *e)
     : condition{c}, then_stmt{t}, else_stmt{e} {}
 
-if_stmt::~if_stmt() {
-    delete condition;
-    delete then_stmt;
-    delete else_stmt;
-}
-
 llvm::Value *if_stmt::gen_ir() {
-    auto c = condition->gen_ir();
+    auto c = as_cond(condition->gen_ir());
     auto fun = builder.GetInsertBlock()->getParent();
     auto then_bb = llvm::BasicBlock::Create(context, "then", fun);
     auto else_bb = llvm::BasicBlock::Create(context, "else");
@@ -976,6 +2677,16 @@ llvm::Value *if_stmt::gen_ir() {
     return con_bb;
 }
 
+void if_stmt::deps(loop_info &l) const {
+    condition->deps(l);
+    l.enter();
+    then_stmt->deps(l);
+    l.leave();
+    l.enter();
+    else_stmt->deps(l);
+    l.leave();
+}
+
 void if_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "if_stmt" << std::endl;
@@ -988,11 +2699,6 @@ void if_stmt::dump(int s) const {
  */
 while_stmt::while_stmt(expr *c, stmt *b) : condition{c}, body{b} {}
 
-while_stmt::~while_stmt() {
-    delete condition;
-    delete body;
-}
-
 llvm::Value *while_stmt::gen_ir() {
     auto fun = builder.GetInsertBlock()->getParent();
 
@@ -1004,7 +2710,7 @@ llvm::Value *while_stmt::gen_ir() {
 
     builder.CreateBr(cond);
     builder.SetInsertPoint(cond);
-    auto c = condition->gen_ir();
+    auto c = as_cond(condition->gen_ir());
     builder.CreateCondBr(c, loop, after);
 
     builder.SetInsertPoint(loop);
@@ -1018,6 +2724,15 @@ llvm::Value *while_stmt::gen_ir() {
 
     return after;
 }
+void while_stmt::deps(loop_info &l) const {
+    condition->deps(l);
+    l.enter();
+    ++l.loops;
+    body->deps(l);
+    --l.loops;
+    l.leave();
+}
+
 void while_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "while_stmt" << std::endl;
@@ -1026,40 +2741,205 @@ void while_stmt::dump(int s) const {
 }
 
 /*
- * for_stmt class
+ * loop_info class
+ */
+loop_info::loop_info(const std::string &i) : index{i}, loops{0} {}
+
+/*
+ * remember only first reason, it is reported
+ */
+void loop_info::fail(const std::string &reason) {
+    if (unsafe.empty())
+        unsafe = reason;
+}
+
+/*
+ * statement which cannot run in outlined body, not even in loop declared
+ * parallel
+ */
+void loop_info::forbid(const std::string &reason) {
+    if (forbidden.empty())
+        forbidden = reason;
+    fail(reason);
+}
+
+void loop_info::read(const std::string &n) {
+    if (defined.count(n) == 0)
+        exposed.insert(n);
+    reads.insert(n);
+}
+
+void loop_info::write(const std::string &n) {
+    defined.insert(n);
+    writes.insert(n);
+}
+
+/*
+ * statements between enter and leave may not run, writes in them do not
+ * define variable for the rest of iteration
+ */
+void loop_info::enter() {
+    scopes.push_back(defined);
+}
+
+void loop_info::leave() {
+    defined = scopes.back();
+    scopes.pop_back();
+}
+
+/*
+ * for_stmt class
+ */
+for_stmt::for_stmt(const std::string &n, expr *f, int d, expr *t,
+        std::list<reduction> r, stmt *b, int l)
+    : name{n}, from{f}, to{t}, dir{d}, reductions{std::move(r)}, body{b},
+    line{l}, parallel{false}, proven{false} {}
+
+void for_stmt::set_parallel() {
+    parallel = true;
+}
+
+/*
+ * Dependence analysis of body. Returns reason why iterations may depend
+ * on each other, empty string when they are independent. Scalars which
+ * every iteration writes before reading are collected to privates.
+ */
+std::string for_stmt::analyze() {
+    auto l = loop_info{name};
+    from->deps(l);
+    to->deps(l);
+    auto bounds = l.reads;
+    body->deps(l);
+    forbidden = l.forbidden;
+
+    auto reduced = std::set<std::string>{};
+    for (auto &r : reductions)
+        reduced.insert(r.name);
+    privates.clear();
+    for (auto &n : l.writes)
+        if (n != name && reduced.count(n) == 0 && l.exposed.count(n) == 0
+                && l.defined.count(n) != 0)
+            privates.push_back(n);
+
+    if (!l.unsafe.empty())
+        return l.unsafe;
+    if (l.writes.count(name) != 0)
+        return "writes index " + name;
+    for (auto &n : bounds)
+        if (l.writes.count(n) != 0)
+            return "bound depends on " + n;
+    for (auto &n : l.writes)
+        if (n != name && reduced.count(n) == 0 && (l.exposed.count(n) != 0
+                    || l.defined.count(n) == 0))
+            return "scalar " + n + " carries value between iterations";
+    for (auto &a : l.arrays)
+        for (auto &b : l.arrays)
+            if (a.name == b.name && (a.write || b.write)
+                    && !independent(a, b, l.writes))
+                return "loop-carried dependence on " + a.name;
+    /* noalias of parameters is known only after whole module is generated */
+    for (auto &a : l.arrays)
+        for (auto &b : l.arrays)
+            if (a.name != b.name && (a.write || b.write)
+                    && (is_ref_param(a.name) || is_ref_param(b.name)))
+                return "parameter " + a.name + " may alias " + b.name;
+    for (auto &n : l.reads)
+        if (is_ref_param(n))
+            return "var parameter " + n + " may alias";
+    for (auto &n : l.writes)
+        if (is_ref_param(n))
+            return "var parameter " + n + " may alias";
+    return "";
+}
+
+/*
+ * print decision about loop to stderr once, reason is empty for
+ * parallelized loops
+ */
+void for_stmt::report(const std::string &reason) const {
+    static std::set<const for_stmt *> reported;
+    if (!autopar_report || !reported.insert(this).second)
+        return;
+    auto fun = builder.GetInsertBlock()->getParent();
+    std::cerr << "autopar: " << fun->getName().str() << ":" << line
+        << ": for " << name << ": ";
+    if (!reason.empty()) {
+        std::cerr << "not parallelized, " << reason << std::endl;
+        return;
+    }
+    std::cerr << "parallelized";
+    for (auto &n : privates)
+        std::cerr << " private " << n;
+    for (auto &r : reductions)
+        std::cerr << " reduce " << r.name;
+    std::cerr << std::endl;
+}
+
+/*
+ * Replace every accumulator by private copy set to identity of its operator.
+ * Returns the shared accumulators in order of reductions.
  */
-for_stmt::for_stmt(const std::string &n, expr *f, int d, expr *t, stmt *b)
-    : name{n}, from{f}, to{t}, dir{d}, body{b} {}
+std::vector<llvm::Value *> for_stmt::privatize() {
+    auto fun = builder.GetInsertBlock()->getParent();
+    auto shared = std::vector<llvm::Value *>{};
+    for (auto &r : reductions) {
+        if (named_vals.count(r.name) == 0) {
+            std::cout << "reduce error: " << r.name << std::endl;
+            shared.push_back(nullptr);
+            continue;
+        }
+        shared.push_back(named_vals.get(r.name));
+        auto t = named_vals.get(r.name)->getType()->getPointerElementType();
+        auto p = create_entry_alloca(fun, t, r.name);
+        builder.CreateStore(reduce_identity(r.op, t), p);
+        named_vals.set(r.name, p);
+        const_vals.set(r.name, p);
+    }
+    return shared;
+}
 
-for_stmt::~for_stmt() {
-    delete from;
-    delete to;
-    delete body;
+/*
+ * Fold private copies back into shared accumulators.
+ */
+void for_stmt::combine(const std::vector<llvm::Value *> &shared) {
+    auto it = shared.begin();
+    for (auto &r : reductions) {
+        auto s = *(it++);
+        if (s == nullptr)
+            continue;
+        auto p = named_vals.get(r.name);
+        auto c = reduce_combine(r.op, builder.CreateLoad(s, r.name.c_str()),
+                builder.CreateLoad(p, r.name.c_str()));
+        builder.CreateStore(c, s);
+        named_vals.set(r.name, s);
+        const_vals.set(r.name, s);
+    }
 }
 
-llvm::Value *for_stmt::gen_ir() {
+/*
+ * Emit the loop over index variable v which already holds first value.
+ * The to expression is evaluated before every iteration unless limit is
+ * given. Outlined loops are chunks of parallel loop, break is not allowed.
+ */
+llvm::BasicBlock *for_stmt::gen_loop(llvm::Value *v, llvm::Value *limit,
+        int d, bool outlined) {
     /* get current function */
     auto fun = builder.GetInsertBlock()->getParent();
 
-    /* look up index variable and store from expression */
-    auto v = named_vals[name];
-    auto f = from->gen_ir();
-    builder.CreateStore(f, v);
-
     auto cond = llvm::BasicBlock::Create(context, "cond", fun);
     auto loop = llvm::BasicBlock::Create(context, "loop", fun);
     auto after = llvm::BasicBlock::Create(context, "after");
     auto backup_break = break_bb;
-    break_bb = after;
+    break_bb = outlined ? nullptr : after;
     builder.CreateBr(cond);
 
     builder.SetInsertPoint(cond);
 
     auto cur_val = builder.CreateLoad(v, name.c_str());
     auto step = llvm::ConstantInt::getSigned(
-            llvm::IntegerType::getInt64Ty(context), dir);
-    auto t = to->gen_ir();
-    if (dir == DIR_TO)
+            llvm::IntegerType::getInt64Ty(context), d);
+    auto t = limit == nullptr ? to->gen_ir() : limit;
+    if (d == DIR_TO)
         t = builder.CreateICmpSLE(cur_val, t, "le");
     else
         t = builder.CreateICmpSGE(cur_val, t, "ge");
@@ -1067,12 +2947,18 @@ llvm::Value *for_stmt::gen_ir() {
     builder.CreateCondBr(t, loop, after);
 
     builder.SetInsertPoint(loop);
+    if (!reductions.empty())
+        ++reduce_depth;
     body->gen_ir();
+    if (!reductions.empty())
+        --reduce_depth;
 
     cur_val = builder.CreateLoad(v, name.c_str());
     auto next_val = builder.CreateAdd(cur_val, step, "nextval");
     builder.CreateStore(next_val, v);
-    builder.CreateBr(cond);
+    auto latch = builder.CreateBr(cond);
+    if (outlined || proven || !reductions.empty())
+        mark_vectorize(latch);
 
     fun->getBasicBlockList().push_back(after);
     builder.SetInsertPoint(after);
@@ -1082,9 +2968,257 @@ llvm::Value *for_stmt::gen_ir() {
     return after;
 }
 
+llvm::Value *for_stmt::gen_ir() {
+    if (parallel) {
+        /* independence is asserted, analysis only finds privates */
+        analyze();
+        if (!forbidden.empty()) {
+            std::cout << "for_stmt error: parallel for " << name << " "
+                << forbidden << std::endl;
+            return nullptr;
+        }
+        return gen_parallel();
+    }
+
+    if (autopar) {
+        auto reason = par_depth > 0 ? "nested in parallel loop" : analyze();
+        auto f = affine{0, {}, 0};
+        auto t = affine{0, {}, 0};
+        auto known = from->affine_form(name, f) && to->affine_form(name, t)
+            && affine_const(f) && affine_const(t);
+        auto trip = dir == DIR_TO ? t.k - f.k + 1 : f.k - t.k + 1;
+        if (reason.empty() && known && trip < AUTOPAR_MIN_TRIP)
+            reason = "trip count " + std::to_string(trip) + " below threshold";
+        report(reason);
+        if (reason.empty()) {
+            proven = true;
+            return known ? gen_parallel() : gen_versioned();
+        }
+    }
+
+    /* look up index variable and store from expression */
+    auto v = named_vals.get(name);
+    auto f = from->gen_ir();
+    builder.CreateStore(f, v);
+
+    auto shared = privatize();
+    auto after = gen_loop(v, nullptr, dir, false);
+    combine(shared);
+
+    return after;
+}
+
+/*
+ * Move body of parallel loop to function void (i8 **ctx, i64 lo, i64 hi)
+ * which runs iterations lo..hi. Variables are reached through addresses
+ * in ctx, loop index and accumulators are private to each call.
+ */
+llvm::Function *for_stmt::outline(
+        const std::vector<std::pair<std::string, llvm::Value *>> &captured) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto i8pp = llvm::Type::getInt8PtrTy(context)->getPointerTo();
+    auto prev_bb = builder.GetInsertBlock();
+
+    auto fun_type = llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+            std::vector<llvm::Type *>{i8pp, i64, i64}, false);
+    auto fun = llvm::Function::Create(fun_type,
+            llvm::Function::InternalLinkage,
+            prev_bb->getParent()->getName() + ".par", module.get());
+    auto arg = fun->arg_begin();
+    auto ctx = &*(arg++);
+    auto lo = &*(arg++);
+    auto hi = &*arg;
+    ctx->setName("ctx");
+    lo->setName("lo");
+    hi->setName("hi");
+
+    /* variables are rebound to captured addresses in scope of body */
+    auto named = std::vector<bool>{};
+    for (auto &c : captured)
+        named.push_back(named_vals.count(c.first));
+    auto backup_group = spawn_group;
+    named_vals.push();
+    const_vals.push();
+    spawn_group = nullptr;
+
+    auto bb = llvm::BasicBlock::Create(context, "entry", fun);
+    builder.SetInsertPoint(bb);
+
+    for (size_t k = 0; k < captured.size(); ++k) {
+        auto &n = captured[k].first;
+        auto p = builder.CreateLoad(builder.CreateConstInBoundsGEP1_64(ctx, k));
+        auto v = builder.CreateBitCast(p, captured[k].second->getType(),
+                n.c_str());
+        if (named[k])
+            named_vals.set(n, v);
+        const_vals.set(n, v);
+    }
+    auto last = builder.CreateLoad(builder.CreateBitCast(
+                builder.CreateLoad(builder.CreateConstInBoundsGEP1_64(ctx,
+                        captured.size())), i64->getPointerTo()), "last");
+
+    auto v = builder.CreateAlloca(i64, nullptr, name.c_str());
+    named_vals.set(name, v);
+    const_vals.set(name, v);
+    auto outside = std::vector<std::pair<llvm::Value *, llvm::Value *>>{};
+    for (auto &n : privates) {
+        if (named_vals.count(n) == 0)
+            continue;
+        auto p = builder.CreateAlloca(named_vals.get(n)->getType()
+                ->getPointerElementType(), nullptr, n.c_str());
+        outside.push_back(std::make_pair(named_vals.get(n), p));
+        named_vals.set(n, p);
+        const_vals.set(n, p);
+    }
+    ++par_depth;
+
+    /* chunk runs in direction of loop so its last iteration is the last */
+    auto first = dir == DIR_TO ? lo : hi;
+    auto final = dir == DIR_TO ? hi : lo;
+    builder.CreateStore(first, v);
+    auto shared = privatize();
+    gen_loop(v, final, dir, true);
+    if (!reductions.empty()) {
+        builder.CreateCall(par_lock_fun, std::vector<llvm::Value *>{});
+        combine(shared);
+        builder.CreateCall(par_unlock_fun, std::vector<llvm::Value *>{});
+    }
+
+    /* private variables keep value of the last iteration of whole loop */
+    if (!outside.empty()) {
+        auto copy_bb = llvm::BasicBlock::Create(context, "copy_out", fun);
+        auto ret_bb = llvm::BasicBlock::Create(context, "ret", fun);
+        builder.CreateCondBr(builder.CreateICmpEQ(final, last),
+                copy_bb, ret_bb);
+        builder.SetInsertPoint(copy_bb);
+        for (auto &o : outside)
+            builder.CreateStore(builder.CreateLoad(o.second), o.first);
+        builder.CreateBr(ret_bb);
+        builder.SetInsertPoint(ret_bb);
+    }
+    --par_depth;
+    builder.CreateRetVoid();
+    sync_spawned(fun);
+    verifyFunction(*fun);
+
+    named_vals.pop();
+    const_vals.pop();
+    spawn_group = backup_group;
+
+    builder.SetInsertPoint(prev_bb);
+
+    return fun;
+}
+
+/*
+ * Run iterations lo..hi of outlined body on worker threads.
+ */
+llvm::Value *for_stmt::gen_par_call(llvm::Value *lo, llvm::Value *hi) {
+    auto i8p = llvm::Type::getInt8PtrTy(context);
+    auto fun = builder.GetInsertBlock()->getParent();
+
+    /* pass addresses of all visible variables to outlined body */
+    auto captured = const_vals.entries();
+    auto ctx = create_entry_alloca(fun,
+            llvm::ArrayType::get(i8p, captured.size() + 1), "ctx");
+    for (size_t k = 0; k < captured.size(); ++k)
+        builder.CreateStore(builder.CreateBitCast(captured[k].second, i8p),
+                builder.CreateConstInBoundsGEP2_64(ctx, 0, k));
+
+    /* and the last iteration after them */
+    auto last = create_entry_alloca(fun, llvm::Type::getInt64Ty(context),
+            "last");
+    builder.CreateStore(dir == DIR_TO ? hi : lo, last);
+    builder.CreateStore(builder.CreateBitCast(last, i8p),
+            builder.CreateConstInBoundsGEP2_64(ctx, 0, captured.size()));
+
+    auto body_fun = outline(captured);
+    auto call = builder.CreateCall(par_for_fun, std::vector<llvm::Value *>{
+            body_fun, builder.CreateConstInBoundsGEP2_64(ctx, 0, 0), lo, hi});
+
+    /* index ends as after sequential loop, past to or at from if empty */
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto past = dir == DIR_TO
+        ? builder.CreateAdd(hi, llvm::ConstantInt::getSigned(i64, 1))
+        : builder.CreateSub(lo, llvm::ConstantInt::getSigned(i64, 1));
+    builder.CreateStore(builder.CreateSelect(builder.CreateICmpSLE(lo, hi),
+                past, dir == DIR_TO ? lo : hi), named_vals.get(name));
+    return call;
+}
+
+llvm::Value *for_stmt::gen_parallel() {
+    /* bounds are evaluated once, runtime splits lo..hi */
+    auto f = from->gen_ir();
+    auto t = to->gen_ir();
+    auto lo = dir == DIR_TO ? f : t;
+    auto hi = dir == DIR_TO ? t : f;
+    return gen_par_call(lo, hi);
+}
+
+/*
+ * Loop proved independent with trip count unknown at compile time, take
+ * the parallel version only when it is long enough to pay for threads.
+ */
+llvm::Value *for_stmt::gen_versioned() {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto fun = builder.GetInsertBlock()->getParent();
+
+    auto f = from->gen_ir();
+    auto t = to->gen_ir();
+    auto lo = dir == DIR_TO ? f : t;
+    auto hi = dir == DIR_TO ? t : f;
+
+    auto par_bb = llvm::BasicBlock::Create(context, "par", fun);
+    auto seq_bb = llvm::BasicBlock::Create(context, "seq", fun);
+    auto after = llvm::BasicBlock::Create(context, "versioned");
+    builder.CreateCondBr(builder.CreateICmpSGE(builder.CreateSub(hi, lo),
+                llvm::ConstantInt::getSigned(i64, AUTOPAR_MIN_TRIP - 1)),
+            par_bb, seq_bb);
+
+    builder.SetInsertPoint(par_bb);
+    gen_par_call(lo, hi);
+    builder.CreateBr(after);
+
+    builder.SetInsertPoint(seq_bb);
+    auto v = named_vals.get(name);
+    builder.CreateStore(f, v);
+    auto shared = privatize();
+    gen_loop(v, t, dir, false);
+    combine(shared);
+    builder.CreateBr(after);
+
+    fun->getBasicBlockList().push_back(after);
+    builder.SetInsertPoint(after);
+
+    return after;
+}
+
+/*
+ * nested loop writes its index and may run zero times
+ */
+void for_stmt::deps(loop_info &l) const {
+    from->deps(l);
+    to->deps(l);
+    l.write(name);
+    l.enter();
+    ++l.loops;
+    body->deps(l);
+    --l.loops;
+    for (auto &r : reductions) {
+        l.read(r.name);
+        l.write(r.name);
+    }
+    l.leave();
+}
+
 void for_stmt::dump(int s) const {
     print_spaces(s);
-    std::cout << "for_stmt name: " << name << " dir: " << dir << std::endl;
+    std::cout << "for_stmt name: " << name << " dir: " << dir;
+    if (parallel)
+        std::cout << " parallel";
+    for (auto &r : reductions)
+        std::cout << " reduce: " << r.op << " " << r.name;
+    std::cout << std::endl;
     from->dump(s + 4);
     to->dump(s + 4);
     body->dump(s + 4);
@@ -1094,9 +3228,28 @@ void for_stmt::dump(int s) const {
  * exit class
  */
 llvm::Value *exit_stmt::gen_ir() {
-    auto fun = builder.GetInsertBlock()->getParent()->getName();
-    auto ret = builder.CreateLoad(named_vals[fun], "exit");
-    return builder.CreateRet(ret);
+    /* accumulators would not be combined */
+    if (reduce_depth > 0) {
+        std::cout << "exit_stmt error: exit from reduce loop" << std::endl;
+        return nullptr;
+    }
+    auto fun = builder.GetInsertBlock()->getParent();
+    llvm::Value *ret = nullptr;
+    if (fun->getReturnType()->isVoidTy())
+        ret = builder.CreateRetVoid();
+    else if (named_vals.count(fun->getName()) != 0)
+        ret = builder.CreateRet(
+                builder.CreateLoad(named_vals.get(fun->getName()), "exit"));
+    else
+        ret = builder.CreateRet(
+                llvm::ConstantInt::get(fun->getReturnType(), 0));
+    /* code after exit is unreachable but still has to be in a block */
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "dead", fun));
+    return ret;
+}
+
+void exit_stmt::deps(loop_info &l) const {
+    l.forbid("contains exit");
 }
 
 void exit_stmt::dump(int s) const {
@@ -1109,17 +3262,17 @@ void exit_stmt::dump(int s) const {
  */
 dec_stmt::dec_stmt(var_assign *v) : var{v} {}
 
-dec_stmt::~dec_stmt() {
-    delete var;
-}
-
 
 llvm::Value *dec_stmt::gen_ir() {
-    auto v = var->gen_ir();
-    auto c = builder.CreateLoad(v, "dec");
+    auto v = var->get_ptr();
+    auto c = widen(load_elem(var->get_name(), v));
     auto n = builder.CreateAdd(c, llvm::ConstantInt::getSigned(
                 llvm::IntegerType::getInt64Ty(context), -1), "dec");
-    return builder.CreateStore(n, v);
+    return store_elem(n, v);
+}
+
+void dec_stmt::deps(loop_info &l) const {
+    var->deps(l, true);
 }
 
 void dec_stmt::dump(int s) const {
@@ -1133,18 +3286,18 @@ void dec_stmt::dump(int s) const {
  */
 inc_stmt::inc_stmt(var_assign *v) : var{v} {}
 
-inc_stmt::~inc_stmt() {
-    delete var;
-}
-
 
 llvm::Value *inc_stmt::gen_ir() {
-    auto v = var->gen_ir();
-    auto c = builder.CreateLoad(v, "inc");
+    auto v = var->get_ptr();
+    auto c = widen(load_elem(var->get_name(), v));
     auto n = builder.CreateAdd(c, llvm::ConstantInt::getSigned(
                 llvm::IntegerType::getInt64Ty(context), 1), "inc");
     
-    return builder.CreateStore(n, v);
+    return store_elem(n, v);
+}
+
+void inc_stmt::deps(loop_info &l) const {
+    var->deps(l, true);
 }
 
 void inc_stmt::dump(int s) const {
@@ -1156,76 +3309,234 @@ void inc_stmt::dump(int s) const {
 /*
  * readln_stmt class
  */
-readln_stmt::readln_stmt(var_assign *v) : var{v} {}
-
-readln_stmt::~readln_stmt() {
-    delete var;
-}
+readln_stmt::readln_stmt(std::list<var_assign *> v) : vars{std::move(v)} {}
 
-extern "C" int64_t scanln() {
-    int64_t x;
-    scanf("%ld", &x);
-    return x;
+llvm::Value *readln_stmt::gen_ir() {
+    llvm::Value *r = nullptr;
+    for (auto v : vars)
+        r = v->store(builder.CreateCall(v->is_real() ? scanln_real_fun
+                    : scanln_fun, std::vector<llvm::Value *>{}, "scanln"));
+    return r;
 }
 
-llvm::Value *readln_stmt::gen_ir() {
-    auto v = var->gen_ir();
-    auto c = builder.CreateCall(scanln_fun,
-            std::vector<llvm::Value *>{}, "scanln");
-    return builder.CreateStore(c, v);
+void readln_stmt::deps(loop_info &l) const {
+    l.forbid("performs input or output");
 }
 
 void readln_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "readln_stmt" << std::endl;
-    var->dump(s + 4);
+    for (auto v : vars)
+        v->dump(s + 4);
 }
 
 /*
- * write_stmt class
+ * Single scalar is printed by its own runtime function. Longer lists and
+ * whole arrays are described in array of items, three words each, and
+ * formatted by one runtime call.
  */
-write_stmt::write_stmt(expr *e) : expression{e} {}
-write_stmt::~write_stmt() {
-    delete expression;
-}
+static llvm::Value *gen_write(const std::list<expr *> &exprs, bool newline) {
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto arr = exprs.size() == 1 ? exprs.front()->as_var_access() : nullptr;
+    if (exprs.size() == 1 && (arr == nullptr || arr->array_ref() == nullptr)) {
+        auto v = widen(exprs.front()->gen_ir());
+        auto f = v->getType()->isDoubleTy()
+            ? (newline ? println_real_fun : print_real_fun)
+            : (newline ? println_fun : print_fun);
+        return builder.CreateCall(f, std::vector<llvm::Value *>{v}, "");
+    }
 
-extern "C" void print(int64_t x) {
-    printf("%ld", x);
+    auto items = create_entry_alloca(builder.GetInsertBlock()->getParent(),
+            llvm::ArrayType::get(i64, 3 * exprs.size()), "write_items");
+    auto k = 0;
+    for (auto e : exprs) {
+        int64_t kind = 0;
+        llvm::Value *value = nullptr;
+        llvm::Value *len = llvm::ConstantInt::get(i64, 1);
+        auto a = e->as_var_access();
+        auto ptr = a == nullptr ? nullptr : a->array_ref();
+        if (ptr != nullptr) {
+            auto t = var_types.get(a->get_name());
+            auto elem = elem_type(*t);
+            kind = SFE_WRITE_ARRAY;
+            len = array_len(a->get_name());
+            if (t->get_type() == TYPE_PACKED) {
+                kind |= SFE_WRITE_PACKED;
+                len = llvm::ConstantInt::get(i64,
+                        static_cast<packed_array_type *>(t.get())->get_length());
+            } else if (elem->isDoubleTy()) {
+                kind |= SFE_WRITE_REAL | 8 << SFE_WRITE_SIZE_SHIFT;
+            } else {
+                if (!t->is_signed())
+                    kind |= SFE_WRITE_UNSIGNED;
+                kind |= module->getDataLayout().getTypeAllocSize(elem)
+                    << SFE_WRITE_SIZE_SHIFT;
+            }
+            value = builder.CreatePtrToInt(
+                    builder.CreateConstInBoundsGEP2_64(ptr, 0, 0), i64);
+        } else {
+            value = widen(e->gen_ir());
+            if (value->getType()->isDoubleTy()) {
+                kind = SFE_WRITE_REAL;
+                value = builder.CreateBitCast(value, i64);
+            }
+        }
+        builder.CreateStore(llvm::ConstantInt::get(i64, kind),
+                builder.CreateConstInBoundsGEP2_64(items, 0, k++));
+        builder.CreateStore(value,
+                builder.CreateConstInBoundsGEP2_64(items, 0, k++));
+        builder.CreateStore(len,
+                builder.CreateConstInBoundsGEP2_64(items, 0, k++));
+    }
+    return builder.CreateCall(write_fun, std::vector<llvm::Value *>{
+            builder.CreateConstInBoundsGEP2_64(items, 0, 0),
+            llvm::ConstantInt::get(i64, exprs.size()),
+            llvm::ConstantInt::get(i64, newline)}, "");
 }
 
+/*
+ * write_stmt class
+ */
+write_stmt::write_stmt(std::list<expr *> l) : exprs{std::move(l)} {}
 llvm::Value *write_stmt::gen_ir() {
-    return builder.CreateCall(print_fun,
-            std::vector<llvm::Value *>{expression->gen_ir()}, "");
+    return gen_write(exprs, false);
+}
+
+void write_stmt::deps(loop_info &l) const {
+    l.forbid("performs input or output");
 }
 
 void write_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "write_stmt" << std::endl;
-    expression->dump(s + 4);
+    for (auto e : exprs)
+        e->dump(s + 4);
 }
 
 /*
  * writeln_stmt class
  */
-writeln_stmt::writeln_stmt(expr *e) : expression{e} {}
+writeln_stmt::writeln_stmt(std::list<expr *> l) : exprs{std::move(l)} {}
 
-writeln_stmt::~writeln_stmt() {
-    delete expression;
-}
-
-extern "C" void println(int64_t x) {
-    printf("%ld\n", x);
+llvm::Value *writeln_stmt::gen_ir() {
+    return gen_write(exprs, true);
 }
 
-llvm::Value *writeln_stmt::gen_ir() {
-    return builder.CreateCall(println_fun,
-            std::vector<llvm::Value *>{expression->gen_ir()}, "");
+void writeln_stmt::deps(loop_info &l) const {
+    l.forbid("performs input or output");
 }
 
 void writeln_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "writeln_stmt" << std::endl;
-    expression->dump(s + 4);
+    for (auto e : exprs)
+        e->dump(s + 4);
+}
+
+/*
+ * spawn_stmt class
+ */
+spawn_stmt::spawn_stmt(var_assign *v, const std::string &n, std::list<expr *> p)
+    : var{v}, name{n}, params{std::move(p)} {}
+
+llvm::Value *spawn_stmt::gen_ir() {
+    auto fun = module->getFunction(name);
+    auto scalars = fun != nullptr;
+    if (fun != nullptr) {
+        for (auto &a : fun->args())
+            scalars = scalars && a.getType()->isIntegerTy(64);
+        scalars = scalars && (fun->getReturnType()->isVoidTy()
+                || fun->getReturnType()->isIntegerTy(64));
+    }
+    if (!scalars) {
+        std::cout << "spawn_stmt error: " << name << std::endl;
+        return nullptr;
+    }
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto parent = builder.GetInsertBlock()->getParent();
+
+    /* arguments are evaluated by spawning function, task holds 64-bit words */
+    auto p = std::vector<llvm::Value *>{};
+    for (auto e : params) {
+        auto v = e->gen_ir();
+        if (v == nullptr)
+            return nullptr;
+        v = widen(v);
+        if (!v->getType()->isIntegerTy(64)) {
+            std::cout << "spawn_stmt error: " << name << std::endl;
+            return nullptr;
+        }
+        p.push_back(v);
+    }
+    llvm::Value *dest = nullptr;
+    if (var != nullptr)
+        dest = var->get_ptr();
+    else if (!fun->getReturnType()->isVoidTy())
+        dest = create_entry_alloca(parent, i64, "discard");
+
+    /* task stores 64-bit result, narrow, boolean or real target is refused */
+    if (dest != nullptr
+            && !dest->getType()->getPointerElementType()->isIntegerTy(64)) {
+        std::cout << "spawn_stmt error: " << var->get_name() << std::endl;
+        return nullptr;
+    }
+
+    /* runtime copies arguments and result address into the task */
+    auto args = create_entry_alloca(parent,
+            llvm::ArrayType::get(i64, p.size() + 1), "spawn_args");
+    for (size_t k = 0; k < p.size(); ++k)
+        builder.CreateStore(p[k], builder.CreateConstInBoundsGEP2_64(args, 0, k));
+    builder.CreateStore(dest == nullptr ? llvm::ConstantInt::getSigned(i64, 0)
+            : builder.CreatePtrToInt(dest, i64),
+            builder.CreateConstInBoundsGEP2_64(args, 0, p.size()));
+    auto queued = builder.CreateCall(spawn_fun, std::vector<llvm::Value *>{
+            spawn_thunk(fun), builder.CreateConstInBoundsGEP2_64(args, 0, 0),
+            llvm::ConstantInt::getSigned(i64, p.size() + 1), get_spawn_group()},
+            "spawn");
+
+    /* task was not queued, call it directly */
+    auto inline_bb = llvm::BasicBlock::Create(context, "spawn_inline", parent);
+    auto cont_bb = llvm::BasicBlock::Create(context, "spawn_cont", parent);
+    builder.CreateCondBr(builder.CreateICmpEQ(queued,
+                llvm::ConstantInt::getSigned(i64, 0)), inline_bb, cont_bb);
+    builder.SetInsertPoint(inline_bb);
+    auto r = builder.CreateCall(fun, p);
+    if (dest != nullptr)
+        builder.CreateStore(r, dest);
+    builder.CreateBr(cont_bb);
+    builder.SetInsertPoint(cont_bb);
+
+    return queued;
+}
+
+void spawn_stmt::deps(loop_info &l) const {
+    l.forbid("spawns " + name);
+}
+
+void spawn_stmt::dump(int s) const {
+    print_spaces(s);
+    std::cout << "spawn_stmt name: " << name << std::endl;
+    if (var != nullptr)
+        var->dump(s + 4);
+    for (auto e : params)
+        e->dump(s + 4);
+}
+
+/*
+ * sync_stmt class
+ */
+llvm::Value *sync_stmt::gen_ir() {
+    return builder.CreateCall(sync_fun,
+            std::vector<llvm::Value *>{get_spawn_group()});
+}
+
+void sync_stmt::deps(loop_info &l) const {
+    l.forbid("contains sync");
+}
+
+void sync_stmt::dump(int s) const {
+    print_spaces(s);
+    std::cout << "sync_stmt" << std::endl;
 }
 
 /*
@@ -1238,7 +3549,18 @@ llvm::Value *break_stmt::gen_ir() {
         std::cout << "break_stmt error" << std::endl;
         return nullptr;
     }
-    return builder.CreateBr(break_bb);
+    auto br = builder.CreateBr(break_bb);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "dead",
+                builder.GetInsertBlock()->getParent()));
+    return br;
+}
+
+void break_stmt::deps(loop_info &l) const {
+    /* break of nested loop stays in body */
+    if (l.loops == 0)
+        l.forbid("contains break");
+    else
+        l.fail("contains break");
 }
 
 void break_stmt::dump(int s) const {
@@ -1249,11 +3571,93 @@ void break_stmt::dump(int s) const {
 /*
  * null_stmt class
  */
+void null_stmt::deps(loop_info &l) const {}
+
 void null_stmt::dump(int s) const {
     print_spaces(s);
     std::cout << "null_stmt" << std::endl;
 }
 
+/*
+ * Pointer parameter is noalias when at every call site it points to other
+ * object than the rest of pointer arguments. Procedures reach memory only
+ * through their parameters, so distinct objects are not accessed through
+ * any other pointer. Repeated until no parameter changes, noalias caller
+ * parameters identify objects passed further.
+ */
+void mark_noalias() {
+    auto &dl = module->getDataLayout();
+    for (auto changed = true; changed; ) {
+        changed = false;
+        for (auto &f : *module) {
+            /* exported functions of unit are called from other modules */
+            if (f.isDeclaration() || f.getName() == "main"
+                    || (compiling_unit && f.hasExternalLinkage()))
+                continue;
+            auto calls = std::vector<llvm::CallInst *>{};
+            auto direct = true;
+            for (auto u : f.users()) {
+                auto c = llvm::dyn_cast<llvm::CallInst>(u);
+                direct = direct && c != nullptr && c->getCalledFunction() == &f;
+                calls.push_back(c);
+            }
+            if (!direct)
+                continue;
+            for (auto &a : f.args()) {
+                if (!a.getType()->isPointerTy() || a.hasNoAliasAttr())
+                    continue;
+                auto distinct = true;
+                for (auto c : calls) {
+                    auto obj = llvm::GetUnderlyingObject(
+                            c->getArgOperand(a.getArgNo()), dl);
+                    distinct = distinct && llvm::isIdentifiedObject(obj);
+                    for (unsigned k = 0; k < c->getNumArgOperands(); ++k)
+                        if (k != a.getArgNo()
+                                && c->getArgOperand(k)->getType()->isPointerTy())
+                            distinct = distinct && obj != llvm::GetUnderlyingObject(
+                                        c->getArgOperand(k), dl);
+                }
+                if (distinct) {
+                    f.setDoesNotAlias(a.getArgNo() + 1);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * run optimizations including loop vectorizer on every function of module
+ */
+void optimize_module() {
+    llvm::legacy::FunctionPassManager fpm{module.get()};
+    fpm.add(llvm::createTargetTransformInfoWrapperPass(
+                jit->getTargetMachine().getTargetIRAnalysis()));
+    fpm.add(llvm::createPromoteMemoryToRegisterPass());
+    fpm.add(llvm::createInstructionCombiningPass());
+    fpm.add(llvm::createReassociatePass());
+    fpm.add(llvm::createGVNPass());
+    fpm.add(llvm::createCFGSimplificationPass());
+    fpm.add(llvm::createLoopRotatePass());
+    fpm.add(llvm::createLICMPass());
+    fpm.add(llvm::createIndVarSimplifyPass());
+    fpm.add(llvm::createLoopVectorizePass());
+    fpm.add(llvm::createInstructionCombiningPass());
+    fpm.add(llvm::createCFGSimplificationPass());
+
+    fpm.doInitialization();
+    for (auto &f : *module) {
+        if (f.isDeclaration())
+            continue;
+        if (fast_math) {
+            f.addFnAttr("unsafe-fp-math", "true");
+            f.addFnAttr("no-nans-fp-math", "true");
+        }
+        fpm.run(f);
+    }
+    fpm.doFinalization();
+}
+
 /*
  * main fun
  */
@@ -1261,69 +3665,417 @@ void define_base_func() {
     scanln_fun = llvm::Function::Create(
             llvm::FunctionType::get(llvm::Type::getInt64Ty(context),
                 std::vector<llvm::Type *>{},
-                false), llvm::Function::ExternalLinkage, "scanln", module.get());
+                false), llvm::Function::ExternalLinkage, "sfe_scanln", module.get());
 
     println_fun = llvm::Function::Create(
             llvm::FunctionType::get(llvm::Type::getVoidTy(context),
                 std::vector<llvm::Type *>(1, llvm::Type::getInt64Ty(context)),
-                false), llvm::Function::ExternalLinkage, "println", module.get());
+                false), llvm::Function::ExternalLinkage, "sfe_println", module.get());
 
     print_fun = llvm::Function::Create(
             llvm::FunctionType::get(llvm::Type::getVoidTy(context),
                 std::vector<llvm::Type *>(1, llvm::Type::getInt64Ty(context)),
-                false), llvm::Function::ExternalLinkage, "print", module.get());
+                false), llvm::Function::ExternalLinkage, "sfe_print", module.get());
+
+    scanln_real_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getDoubleTy(context),
+                std::vector<llvm::Type *>{},
+                false), llvm::Function::ExternalLinkage, "sfe_scanln_real", module.get());
+
+    println_real_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>(1, llvm::Type::getDoubleTy(context)),
+                false), llvm::Function::ExternalLinkage, "sfe_println_real", module.get());
+
+    print_real_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>(1, llvm::Type::getDoubleTy(context)),
+                false), llvm::Function::ExternalLinkage, "sfe_print_real", module.get());
+
+    flush_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{},
+                false), llvm::Function::ExternalLinkage, "sfe_flush", module.get());
+
+    write_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{llvm::Type::getInt64PtrTy(context),
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_write", module.get());
+    write_fun->setDoesNotCapture(1);
+
+    eof_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getInt64Ty(context),
+                std::vector<llvm::Type *>{},
+                false), llvm::Function::ExternalLinkage, "sfe_eof", module.get());
+
+    readarray_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getInt64Ty(context),
+                std::vector<llvm::Type *>{llvm::Type::getInt8PtrTy(context),
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_readarray", module.get());
+    readarray_fun->setDoesNotCapture(1);
+
+    readarray_real_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getInt64Ty(context),
+                std::vector<llvm::Type *>{llvm::Type::getDoublePtrTy(context),
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_readarray_real", module.get());
+    readarray_real_fun->setDoesNotCapture(1);
+
+    map_array_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getInt64Ty(context),
+                std::vector<llvm::Type *>{llvm::Type::getInt8PtrTy(context),
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_map_array", module.get());
+    map_array_fun->setDoesNotCapture(1);
+
+    dump_array_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getInt64Ty(context),
+                std::vector<llvm::Type *>{llvm::Type::getInt8PtrTy(context),
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_dump_array", module.get());
+    dump_array_fun->setDoesNotCapture(1);
+
+    auto i8pp = llvm::Type::getInt8PtrTy(context)->getPointerTo();
+    auto body_type = llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+            std::vector<llvm::Type *>{i8pp, llvm::Type::getInt64Ty(context),
+                llvm::Type::getInt64Ty(context)}, false);
+    par_for_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{body_type->getPointerTo(), i8pp,
+                    llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_par_for", module.get());
+
+    par_lock_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{},
+                false), llvm::Function::ExternalLinkage, "sfe_par_lock", module.get());
+
+    par_unlock_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{},
+                false), llvm::Function::ExternalLinkage, "sfe_par_unlock", module.get());
+
+    auto i64p = llvm::Type::getInt64PtrTy(context);
+    auto thunk_type = llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+            std::vector<llvm::Type *>{i64p}, false);
+    spawn_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getInt64Ty(context),
+                std::vector<llvm::Type *>{thunk_type->getPointerTo(), i64p,
+                    llvm::Type::getInt64Ty(context), i64p},
+                false), llvm::Function::ExternalLinkage, "sfe_spawn", module.get());
+
+    sync_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{i64p},
+                false), llvm::Function::ExternalLinkage, "sfe_sync", module.get());
+
+    auto i8p = llvm::Type::getInt8PtrTy(context);
+    alloc_array_fun = llvm::Function::Create(
+            llvm::FunctionType::get(i8p,
+                std::vector<llvm::Type *>{llvm::Type::getInt64Ty(context),
+                    llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_alloc_array", module.get());
+    alloc_array_fun->setDoesNotAlias(0);
+
+    free_array_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{i8p, llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_free_array", module.get());
+
+    hugepages_fun = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{i8p, llvm::Type::getInt64Ty(context)},
+                false), llvm::Function::ExternalLinkage, "sfe_hugepages", module.get());
+
+    /* built-in array functions, name: runtime function, extra argument */
+    auto i64 = llvm::Type::getInt64Ty(context);
+    auto array_funs = std::vector<std::pair<std::string, bool>>{
+        {"sum", false}, {"max", false}, {"min", false}, {"count", true}};
+    builtins.clear();
+    for (auto &b : array_funs) {
+        auto args = std::vector<llvm::Type *>{i64p, i64};
+        if (b.second)
+            args.push_back(i64);
+        auto f = llvm::Function::Create(llvm::FunctionType::get(i64, args,
+                    false), llvm::Function::ExternalLinkage, "sfe_" + b.first,
+                module.get());
+        f->setOnlyReadsMemory();
+        f->setDoesNotThrow();
+        builtins[b.first] = f;
+    }
+    builtins["prefixsum"] = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                std::vector<llvm::Type *>{i64p, i64},
+                false), llvm::Function::ExternalLinkage, "sfe_prefixsum", module.get());
+    builtins["prefixsum"]->setDoesNotThrow();
 }
 
-int main(int argc, char **argv) {
-    if (argc != 2) /* only 1 file to compile */
-        return EXIT_FAILURE;
-    auto in = new std::ifstream{argv[1]};
-    if (in == nullptr) /* cannot opein file */
-        return EXIT_FAILURE;
+static int compile_and_run(int, char **);
 
-    auto parser = yyParser{in};
+/*
+ * Used unit is object file and interface file next to its source, both
+ * named by the unit. Interface is unit of constants and forward
+ * declarations, so it is read by the parser and generated in front of
+ * the program, object file is loaded to JIT as it is.
+ */
+struct unit_use {
+    decl_list *decls;
+    std::string object;
+};
 
-    /* create AST */
-    auto root = parser.yyparse();
+static std::string source_dir(const std::string &file) {
+    auto slash = file.rfind('/');
+    return slash == std::string::npos ? "" : file.substr(0, slash + 1);
+}
 
-    /* init objects */
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-    llvm::InitializeNativeTargetAsmParser();
+/* modification time in nanoseconds, -1 when file does not exist */
+static int64_t mtime(const std::string &file) {
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0)
+        return -1;
+    return st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+}
 
-    jit = llvm::make_unique<llvm::orc::KaleidoscopeJIT>();
+/*
+ * unit is rebuilt by the same compiler with the same code generation
+ * options, in forked process so state of this compilation is untouched
+ */
+static bool build_unit(const std::string &source) {
+    auto argv = std::vector<char *>{const_cast<char *>("llvm-sfe")};
+    if (optimize)
+        argv.push_back(const_cast<char *>("-O"));
+    if (autopar)
+        argv.push_back(const_cast<char *>("-autopar"));
+    if (hugepages)
+        argv.push_back(const_cast<char *>("-hugepages"));
+    if (fast_math)
+        argv.push_back(const_cast<char *>("-ffast-math"));
+    auto file = source;
+    argv.push_back(&file[0]);
+    auto argc = static_cast<int>(argv.size());
+    argv.push_back(nullptr);
+    return run_forked(compile_and_run, argc, argv.data()) == EXIT_SUCCESS;
+}
+
+/*
+ * Read interface of unit and of units it uses, which come first. Unit
+ * with source newer than its object or interface is compiled again,
+ * unit without source is used as it is.
+ */
+static bool use_unit(const std::string &name, const std::string &dir,
+        std::set<std::string> &seen, std::vector<unit_use> &units) {
+    if (!seen.insert(name).second)
+        return true;
+    auto source = dir + name + ".p";
+    auto object = dir + name + ".o";
+    auto interface = dir + name + ".sfi";
+    auto t = mtime(source);
+    if (t >= 0 && (t > mtime(object) || t > mtime(interface))
+            && !build_unit(source)) {
+        std::cout << "uses error: " << name << std::endl;
+        return false;
+    }
+    yyParser parser{interface.c_str()};
+    auto decls = parser.good() ? parser.yyparse() : nullptr;
+    if (decls == nullptr || parser.get_unit() != name) {
+        std::cout << "uses error: " << name << std::endl;
+        return false;
+    }
+    for (auto &u : parser.get_uses())
+        if (!use_unit(u, dir, seen, units))
+            return false;
+    units.push_back(unit_use{static_cast<decl_list *>(decls), object});
+    return true;
+}
+
+/*
+ * write file at once under temporary name, so compilations reading unit
+ * in parallel see old or new file
+ */
+static bool write_file(const std::string &file, const std::string &data) {
+    auto tmp = file + ".XXXXXX";
+    auto fd = mkstemp(&tmp[0]);
+    auto out = fd < 0 ? nullptr : fdopen(fd, "wb");
+    auto ok = out != nullptr && fchmod(fd, 0644) == 0
+        && std::fwrite(data.data(), 1, data.size(), out) == data.size();
+    if (out != nullptr)
+        ok = std::fclose(out) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), file.c_str()) != 0) {
+        if (fd >= 0)
+            std::remove(tmp.c_str());
+        std::cout << "unit error: " << file << std::endl;
+        return false;
+    }
+    return true;
+}
 
-    module = llvm::make_unique<llvm::Module>("module", llvm::getGlobalContext());
+/*
+ * Object file is compiled by target machine of JIT, so it is loaded the
+ * same way as module of program would be.
+ */
+static int emit_unit(const yyParser &parser, const std::string &dir,
+        decl_list *decls) {
+    auto name = parser.get_unit();
+    auto obj = llvm::orc::SimpleCompiler{jit->getTargetMachine()}(*module);
+    if (obj.getBinary() == nullptr) {
+        std::cout << "unit error: " << name << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::ostringstream interface;
+    interface << "unit " << name << ";" << std::endl;
+    auto &uses = parser.get_uses();
+    for (size_t i = 0; i < uses.size(); ++i)
+        interface << (i == 0 ? "uses " : ", ") << uses[i];
+    if (!uses.empty())
+        interface << ";" << std::endl;
+    decls->interface(interface);
+    interface << "end." << std::endl;
+    return write_file(dir + name + ".o", obj.getBinary()->getData().str())
+        && write_file(dir + name + ".sfi", interface.str())
+        ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ * compile source file given with options and run it, -c only compiles;
+ * server calls it in fresh process for each request
+ */
+static int compile_and_run(int argc, char **argv) {
+    char *file = nullptr;
+    for (auto i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "-O")
+            optimize = true;
+        else if (std::string(argv[i]) == "-autopar")
+            autopar = true;
+        else if (std::string(argv[i]) == "-autopar-report")
+            autopar = autopar_report = true;
+        else if (std::string(argv[i]) == "-hugepages")
+            hugepages = true;
+        else if (std::string(argv[i]) == "-ffast-math")
+            fast_math = true;
+        else if (std::string(argv[i]) == "-stats")
+            stats = true;
+        else if (std::string(argv[i]) == "-c")
+            compile_only = true;
+        else {
+            /* arguments after source file belong to program */
+            file = argv[i];
+            sfe_args(argc - i, argv + i);
+            break;
+        }
+    }
+    if (file == nullptr)
+        return EXIT_FAILURE;
+    yyParser parser{file};
+    if (!parser.good()) /* cannot open file */
+        return EXIT_FAILURE;
+
+    /* create AST in arena of compilation unit */
+    ast::compilation_unit unit;
+    unit.root = parser.yyparse();
+    auto root = unit.root;
+    if (root == nullptr)
+        return EXIT_FAILURE;
+    if (stats)
+        unit.stats();
+
+    /* units are rebuilt if needed before this compilation starts */
+    auto dir = source_dir(file);
+    auto seen = std::set<std::string>{parser.get_unit()};
+    auto units = std::vector<unit_use>{};
+    for (auto &u : parser.get_uses())
+        if (!use_unit(u, dir, seen, units))
+            return EXIT_FAILURE;
+    compiling_unit = !parser.get_unit().empty();
+
+    module = llvm::make_unique<llvm::Module>("module", context);
     module->setDataLayout(jit->getTargetMachine().createDataLayout());
 
     /* define writeln, write and readln */
     define_base_func();
 
+    /* reals may be reassociated, so their reductions vectorize */
+    if (fast_math) {
+        auto fmf = llvm::FastMathFlags{};
+        fmf.setUnsafeAlgebra();
+        builder.SetFastMathFlags(fmf);
+    }
+
     auto fun_type = llvm::FunctionType::get(llvm::Type::getInt8Ty(context),
             std::vector<llvm::Type *>{}, false);
-    auto fun = llvm::Function::Create(fun_type,
-            llvm::Function::ExternalLinkage, "main", module.get());
+    /* declarations of unit are generated in function never called */
+    auto fun = compiling_unit
+        ? llvm::Function::Create(fun_type, llvm::Function::InternalLinkage,
+                parser.get_unit() + ".init", module.get())
+        : llvm::Function::Create(fun_type, llvm::Function::ExternalLinkage,
+                "main", module.get());
 
     /* parse and generate LLVM IR */
     auto basic_block = llvm::BasicBlock::Create(context, "main_block", fun);
     builder.SetInsertPoint(basic_block);
+    for (auto &u : units)
+        u.decls->gen_ir();
     root->gen_ir();
     builder.CreateRet(llvm::ConstantInt::getSigned(
                 llvm::IntegerType::getInt8Ty(context), 0));
+    sync_spawned(fun);
+    flush_output(fun);
     verifyFunction(*fun);
+    mark_noalias();
+
+    if (optimize)
+        optimize_module();
 
     /* module->dump(); */ /* print generated llvm ir */
 
+    if (compiling_unit)
+        return emit_unit(parser, dir, static_cast<decl_list *>(root));
+
+    auto handles = std::vector<llvm::orc::KaleidoscopeJIT::ModuleHandleT>{};
+    for (auto &u : units) {
+        handles.emplace_back();
+        if (!jit->addObjectFile(u.object, handles.back())) {
+            std::cout << "uses error: " << u.object << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
     auto h = jit->addModule(std::move(module));
 
-    auto symbol = jit->findSymbol("main");
-    assert(symbol && "func not found");
-    int (*fun_ptr)() = (int (*)())(intptr_t)symbol.getAddress();
-    fun_ptr();
+    if (!compile_only) {
+        auto symbol = jit->findSymbol("main");
+        assert(symbol && "func not found");
+        int (*fun_ptr)() = (int (*)())(intptr_t)symbol.getAddress();
+        fun_ptr();
+    }
 
     jit->removeModule(h);
+    for (auto u : handles)
+        jit->removeModule(u);
 
-    delete root;
-    delete in;
     return EXIT_SUCCESS;
 }
+
+int main(int argc, char **argv) {
+    /* init objects */
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+
+    jit = llvm::make_unique<llvm::orc::KaleidoscopeJIT>();
+
+    /* keep LLVM initialized and compile on requests of sfe-client */
+    if (argc == 3 && std::string(argv[1]) == "-server")
+        return serve(argv[2], compile_and_run);
+    if (argc > 1 && std::string(argv[1]) == "-batch")
+        return batch(argc - 2, argv + 2, compile_and_run);
+    return compile_and_run(argc, argv);
+}
@@ -1,12 +1,24 @@
 #ifndef _ast_h_k38skxu3o2pxj3ua
 #define _ast_h_k38skxu3o2pxj3ua
 
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <list>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "llvm/IR/Value.h"
 
+namespace llvm {
+class BasicBlock;
+class Function;
+}
+
 namespace ast {
 
 const int DIR_TO = 1;
@@ -14,14 +26,201 @@ const int DIR_DOWNTO = -1;
 
 const int TYPE_INT = 1;
 const int TYPE_ARR = 2;
+const int TYPE_OPEN_ARR = 3;
+const int TYPE_BOOL = 4;
+const int TYPE_PACKED = 5;
+const int TYPE_REAL = 6;
+
+const int RED_SUM = 1;
+const int RED_PROD = 2;
+const int RED_MIN = 3;
+const int RED_MAX = 4;
+const int RED_AND = 5;
+const int RED_OR = 6;
+
+/*
+ * reduction struct
+ * Accumulator of for_stmt privatised per thread or vector lane.
+ */
+struct reduction {
+    int op;
+    std::string name;
+};
+
+/*
+ * affine struct
+ * Subscript index * i + sum of coefficient * invariant + k where i is index
+ * variable of analysed loop.
+ */
+struct affine {
+    long int index;
+    std::map<std::string, long int> terms;
+    long int k;
+};
+
+/*
+ * access struct
+ * Read or write of array element in body of analysed loop, valid when all
+ * subscripts are affine.
+ */
+struct access {
+    std::string name;
+    std::vector<affine> subs;
+    bool valid;
+    bool write;
+};
+
+/*
+ * intern, symbol_name
+ * Identifiers are numbered once, equal names get equal numbers. Name may
+ * be given by text of token with hash computed by lexer.
+ */
+int intern(const std::string &);
+int intern(const char *, size_t, uint64_t);
+const std::string &symbol_name(int);
+
+/*
+ * symbol_table class
+ * Values of identifiers indexed by their numbers. Scope pushed at entry of
+ * function hides all outer bindings. Binding replaced in scope is saved to
+ * undo log and restored when the scope is popped, so push is constant
+ * and pop linear in number of names bound in the scope.
+ */
+template <typename T>
+class symbol_table {
+    private:
+        struct entry {
+            T val;
+            size_t scope;
+        };
+        std::vector<entry> cur;
+        std::vector<std::pair<int, entry>> undo;
+        std::vector<size_t> marks{0};
+    public:
+        bool count(int id) const {
+            return static_cast<size_t>(id) < cur.size()
+                && cur[id].scope == marks.size();
+        }
+        bool count(const std::string &n) const {
+            return count(intern(n));
+        }
+        T get(int id) const {
+            return count(id) ? cur[id].val : T{};
+        }
+        T get(const std::string &n) const {
+            return get(intern(n));
+        }
+        void set(int id, T v) {
+            if (static_cast<size_t>(id) >= cur.size())
+                cur.resize(id + 1, entry{T{}, 0});
+            if (cur[id].scope != marks.size())
+                undo.push_back(std::make_pair(id, cur[id]));
+            cur[id] = entry{std::move(v), marks.size()};
+        }
+        void set(const std::string &n, T v) {
+            set(intern(n), std::move(v));
+        }
+        void push() {
+            marks.push_back(undo.size());
+        }
+        void pop() {
+            for (; undo.size() > marks.back(); undo.pop_back())
+                cur[undo.back().first] = undo.back().second;
+            marks.pop_back();
+        }
+        /* names bound in current scope in order of binding */
+        std::vector<std::pair<std::string, T>> entries() const {
+            auto l = std::vector<std::pair<std::string, T>>{};
+            for (auto i = marks.back(); i < undo.size(); ++i)
+                l.push_back(std::make_pair(symbol_name(undo[i].first),
+                            cur[undo[i].first].val));
+            return l;
+        }
+        void clear() {
+            cur.clear();
+            undo.clear();
+            marks.assign(1, 0);
+        }
+};
+
+/*
+ * loop_info class
+ * Variables and array elements used in body of for_stmt, gathered by
+ * dependence analysis. A scalar is exposed when an iteration may read it
+ * before writing it, defined when every iteration writes it.
+ */
+class loop_info {
+    public:
+        std::string index;
+        std::string unsafe;
+        std::string forbidden;
+        int loops;
+        std::set<std::string> reads, writes, exposed, defined;
+        std::list<access> arrays;
+        loop_info(const std::string &);
+        void fail(const std::string &);
+        void forbid(const std::string &);
+        void read(const std::string &);
+        void write(const std::string &);
+        void enter();
+        void leave();
+    private:
+        std::list<std::set<std::string>> scopes;
+};
+
+class node;
+
+/*
+ * arena class
+ * Memory of AST nodes taken by bumping pointer in large blocks. Nodes are
+ * destroyed and all blocks released at once together with arena.
+ */
+class arena {
+    private:
+        std::vector<char *> blocks;
+        std::vector<node *> nodes;
+        char *pos = nullptr;
+        char *end = nullptr;
+        size_t bytes = 0;
+    public:
+        static arena *current;
+        arena() = default;
+        arena(const arena &) = delete;
+        arena &operator=(const arena &) = delete;
+        ~arena();
+        void *alloc(size_t);
+        size_t get_nodes() const;
+        size_t get_bytes() const;
+        size_t get_blocks() const;
+};
+
+/*
+ * compilation_unit class
+ * Compilation unit, owns arena with AST of one source file and makes it
+ * current while unit exists.
+ */
+class compilation_unit {
+    private:
+        arena nodes;
+        arena *prev;
+    public:
+        node *root = nullptr;
+        compilation_unit();
+        ~compilation_unit();
+        void stats() const;
+};
 
 /* 
  * node abstract class
- * Base class for all nodes of AST.
+ * Base class for all nodes of AST, nodes created by new live in current
+ * arena and are never deleted one by one.
  */
 class node {
     public:
+        node();
         virtual ~node();
+        static void *operator new(size_t);
+        static void operator delete(void *);
         virtual void dump(int) const = 0;
         virtual llvm::Value *gen_ir() = 0;
         void print_spaces(int) const;
@@ -35,58 +234,150 @@ class type : public node {
     public:
         virtual ~type();
         virtual int get_type() const = 0;
-        virtual int get_size() const = 0;
-        virtual int get_from() const = 0;
+        virtual long int get_size() const = 0;
+        virtual long int get_from() const = 0;
+        virtual std::vector<std::pair<long int, long int>> get_bounds() const;
+        virtual int get_bits() const;
+        virtual bool is_signed() const;
+        virtual bool is_real() const;
+        virtual void print(std::ostream &) const = 0;
         virtual llvm::Value *gen_ir();
 };
 
+/*
+ * int_type class
+ * Integer of given width, values are widened to 64 bits when loaded and
+ * truncated when stored. Scalar variables are always 64 bits wide.
+ */
 class int_type : public type {
+    private:
+        const int bits;
+        const bool sign;
+    public:
+        int_type(int = 64, bool = true);
+        virtual int get_type() const;
+        virtual long int get_size() const;
+        virtual long int get_from() const;
+        virtual int get_bits() const;
+        virtual bool is_signed() const;
+        virtual void dump(int) const;
+        virtual void print(std::ostream &) const;
+};
+
+/*
+ * bool_type class
+ * Truth value, i1 in expressions and one byte in memory.
+ */
+class bool_type : public type {
+    public:
+        virtual int get_type() const;
+        virtual long int get_size() const;
+        virtual long int get_from() const;
+        virtual int get_bits() const;
+        virtual bool is_signed() const;
+        virtual void dump(int) const;
+        virtual void print(std::ostream &) const;
+};
+
+/*
+ * real_type class
+ * Double precision floating point number.
+ */
+class real_type : public type {
     public:
         virtual int get_type() const;
-        virtual int get_size() const;
-        virtual int get_from() const;
+        virtual long int get_size() const;
+        virtual long int get_from() const;
+        virtual bool is_real() const;
         virtual void dump(int) const;
+        virtual void print(std::ostream &) const;
 };
 
+/*
+ * array_type class
+ * Bounds of every dimension, elements are stored in row-major order.
+ */
 class array_type : public type {
     protected:
-        int from, to;
+        std::vector<std::pair<long int, long int>> bounds;
+        std::shared_ptr<type> elem;
     public:
-        array_type(int, int);
+        array_type(std::vector<std::pair<long int, long int>>,
+                std::shared_ptr<type>);
         virtual int get_type() const;
-        virtual int get_size() const;
-        virtual int get_from() const;
+        virtual long int get_size() const;
+        virtual long int get_from() const;
+        virtual std::vector<std::pair<long int, long int>> get_bounds() const;
+        virtual int get_bits() const;
+        virtual bool is_signed() const;
+        virtual bool is_real() const;
         virtual void dump(int) const;
+        virtual void print(std::ostream &) const;
+};
+
+/*
+ * open_array_type class
+ * Array parameter of any length indexed from 0, length is passed with it.
+ */
+class open_array_type : public array_type {
+    public:
+        open_array_type(std::shared_ptr<type>);
+        virtual int get_type() const;
+        virtual void dump(int) const;
+        virtual void print(std::ostream &) const;
+};
+
+/*
+ * packed_array_type class
+ * Array of boolean stored as bitset in 64-bit words, element with row-major
+ * position p is bit p mod 64 of word p div 64.
+ */
+class packed_array_type : public array_type {
+    public:
+        packed_array_type(std::vector<std::pair<long int, long int>>);
+        virtual int get_type() const;
+        virtual long int get_size() const;
+        virtual int get_bits() const;
+        long int get_length() const;
+        virtual void dump(int) const;
+        virtual void print(std::ostream &) const;
+};
+
+/*
+ * param struct
+ * Formal parameter of procedure or function.
+ */
+struct param {
+    std::string name;
+    std::shared_ptr<type> par_type;
+    bool by_ref;
 };
 
 /* base decl class */
 class decl : public node {
     public:
         virtual void add_type(std::shared_ptr<type>);
+        virtual void interface(std::ostream &) const;
         virtual ~decl();
 };
 
+/*
+ * decl_list class
+ * Declarations of block in order, kept flat so long lists are walked
+ * without recursion.
+ */
 class decl_list : public decl {
     protected:
-        decl *declaration;
-        decl_list *next;
-    public:
-        decl_list(decl *, decl_list *);
-        virtual ~decl_list();
-        llvm::Value *gen_ir();
-        virtual void dump(int) const;
-};
-
-class null_decl_list : public decl_list {
+        std::vector<decl *> decls;
     public:
-        null_decl_list();
+        void add(decl *);
         llvm::Value *gen_ir();
+        virtual void interface(std::ostream &) const;
         virtual void dump(int) const;
 };
 
 class var_decl_list : public decl_list {
     public:
-        var_decl_list(decl *, decl_list *);
         virtual void add_type(std::shared_ptr<type>);
         virtual void dump(int) const;
 };
@@ -96,24 +387,21 @@ class stmt : public node {
     public:
         virtual ~stmt();
         virtual llvm::Value *gen_ir() { return nullptr; }
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
+/*
+ * stmt_list class
+ * Statements of compound statement in order, kept flat as decl_list.
+ */
 class stmt_list : public stmt {
     protected:
-        stmt *statement;
-        stmt_list *next;
-    public:
-        stmt_list(stmt*, stmt_list*);
-        virtual ~stmt_list();
-        virtual llvm::Value *gen_ir();
-        virtual void dump(int) const;
-};
-
-class null_stmt_list : public stmt_list {
+        std::vector<stmt *> stmts;
     public:
-        null_stmt_list();
+        void add(stmt *);
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -124,25 +412,30 @@ class block : public node {
         stmt *body;
     public:
         block(decl_list *, stmt *);
-        virtual ~block();
         virtual llvm::Value *gen_ir();
         virtual void dump(int) const;
 };
 
 /* base expr class */
+class var_access;
+
 class expr : public node {
     public:
         virtual ~expr();
+        virtual var_access *as_var_access();
+        virtual void deps(loop_info &) const;
+        virtual bool affine_form(const std::string &, affine &) const;
 };
 
 /* declarations */
 class const_decl : public decl {
     protected:
         std::string name;
-        int val;
+        long int val;
     public:
-        const_decl(const std::string&, int);
+        const_decl(const std::string&, long int);
         llvm::Value *gen_ir(); 
+        virtual void interface(std::ostream &) const;
         virtual void dump(int) const;
 };
 
@@ -160,22 +453,26 @@ class var_decl : public decl {
 class proc_decl : public decl {
     protected:
         std::string name;
-        std::list<std::string> args;
+        std::list<param> args;
         block *body;
     public:
-        proc_decl(const std::string &, std::list<std::string>, block *);
+        proc_decl(const std::string &, std::list<param>, block *);
         llvm::Value *gen_ir();
+        virtual void interface(std::ostream &) const;
         virtual void dump(int) const;
 };
 
 class func_decl : public decl {
     protected:
         std::string name;
-        std::list<std::string> args;
+        std::list<param> args;
+        std::shared_ptr<type> ret_type;
         block *body;
     public:
-        func_decl(const std::string &, std::list<std::string>, block *);
+        func_decl(const std::string &, std::list<param>,
+                std::shared_ptr<type>, block *);
         llvm::Value *gen_ir();
+        virtual void interface(std::ostream &) const;
         virtual void dump(int) const;
 };
 
@@ -185,7 +482,7 @@ class binary_expr : public expr {
         expr *left, *right;
     public:
         binary_expr(expr *, expr *);
-        virtual ~binary_expr();
+        virtual void deps(loop_info &) const;
 };
 
 class eq_expr : public binary_expr {
@@ -234,6 +531,7 @@ class add_expr : public binary_expr {
     public:
         add_expr(expr *, expr *);
         virtual llvm::Value *gen_ir();
+        virtual bool affine_form(const std::string &, affine &) const;
         virtual void dump(int) const;
 };
 
@@ -241,6 +539,7 @@ class sub_expr : public binary_expr {
     public:
         sub_expr(expr *, expr *);
         virtual llvm::Value *gen_ir();
+        virtual bool affine_form(const std::string &, affine &) const;
         virtual void dump(int) const;
 };
 
@@ -255,6 +554,7 @@ class mul_expr : public binary_expr {
     public:
         mul_expr(expr *, expr *);
         virtual llvm::Value *gen_ir();
+        virtual bool affine_form(const std::string &, affine &) const;
         virtual void dump(int) const;
 };
 
@@ -265,6 +565,13 @@ class div_expr : public binary_expr {
         virtual void dump(int) const;
 };
 
+class real_div_expr : public binary_expr {
+    public:
+        real_div_expr(expr *, expr *);
+        virtual llvm::Value *gen_ir();
+        virtual void dump(int) const;
+};
+
 class mod_expr : public binary_expr {
     public:
         mod_expr(expr *, expr *);
@@ -291,13 +598,14 @@ class unary_expr : public expr {
         expr *child;
     public:
         unary_expr(expr *);
-        virtual ~unary_expr();
+        virtual void deps(loop_info &) const;
 };
 
 class minus_expr : public unary_expr {
     public:
         minus_expr(expr *);
         virtual llvm::Value *gen_ir();
+        virtual bool affine_form(const std::string &, affine &) const;
         virtual void dump(int) const;
 };
 
@@ -317,8 +625,8 @@ class proc_call : public stmt {
         std::list<expr *> params;
     public:
         proc_call(const std::string &, std::list<expr *>);
-        ~proc_call();
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -331,33 +639,43 @@ class call : public expr {
         std::list<expr *> params;
     public:
         call(const std::string &, std::list<expr *>);
-        ~call();
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
 class var_access : public expr {
     protected:
         std::string name;
+        int id;
         std::list<expr *> idxs;
     public:
         var_access(const std::string &);
-        ~var_access();
         void add_idx(expr *);
+        std::string get_name() const;
+        llvm::Value *array_ref() const;
+        llvm::Value *get_ptr();
+        virtual var_access *as_var_access();
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
+        virtual bool affine_form(const std::string &, affine &) const;
         virtual void dump(int) const;
 };
 
 class var_assign : public node {
     protected:
         std::string name;
+        int id;
         std::list<expr *> idxs;
     public:
         var_assign(const std::string &);
-        ~var_assign();
         void add_idx(expr *);
         std::string get_name() const;
-        llvm::Value *get_idx() const;
+        llvm::Value *get_ptr();
+        llvm::Value *array_ref() const;
+        bool is_real() const;
+        llvm::Value *store(llvm::Value *);
+        void deps(loop_info &, bool) const;
         virtual llvm::Value *gen_ir();
         virtual void dump(int) const;
 };
@@ -368,6 +686,25 @@ class numb : public expr {
     public:
         numb(long int);
         virtual llvm::Value *gen_ir();
+        virtual bool affine_form(const std::string &, affine &) const;
+        virtual void dump(int) const;
+};
+
+class real_numb : public expr {
+    protected:
+        double val;
+    public:
+        real_numb(double);
+        virtual llvm::Value *gen_ir();
+        virtual void dump(int) const;
+};
+
+class bool_const : public expr {
+    protected:
+        bool val;
+    public:
+        bool_const(bool);
+        virtual llvm::Value *gen_ir();
         virtual void dump(int) const;
 };
 
@@ -382,8 +719,8 @@ class compound_stmt : public stmt {
         stmt_list *list;
     public:
         compound_stmt(stmt_list *);
-        virtual ~compound_stmt();
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -394,7 +731,7 @@ class assign_stmt : public stmt {
     public:
         assign_stmt(var_assign *, expr *);
         llvm::Value *gen_ir();
-        virtual ~assign_stmt();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -404,8 +741,8 @@ class if_stmt : public stmt {
         stmt *then_stmt, *else_stmt;
     public:
         if_stmt(expr *, stmt *, stmt *);
-        virtual ~if_stmt();
         llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -415,8 +752,8 @@ class while_stmt : public stmt {
         stmt *body;
     public:
         while_stmt(expr *, stmt *);
-        virtual ~while_stmt();
         llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -425,17 +762,36 @@ class for_stmt : public stmt {
         const std::string name;
         expr *from, *to;
         const int dir;
+        std::list<reduction> reductions;
         stmt *body;
-    public:
-        for_stmt(const std::string &, expr *, int, expr *, stmt *);
-        virtual ~for_stmt();
+        const int line;
+        bool parallel;
+        bool proven;
+        std::list<std::string> privates;
+        std::string forbidden;
+        std::string analyze();
+        void report(const std::string &) const;
+        std::vector<llvm::Value *> privatize();
+        void combine(const std::vector<llvm::Value *> &);
+        llvm::BasicBlock *gen_loop(llvm::Value *, llvm::Value *, int, bool);
+        llvm::Function *outline(
+                const std::vector<std::pair<std::string, llvm::Value *>> &);
+        llvm::Value *gen_par_call(llvm::Value *, llvm::Value *);
+        llvm::Value *gen_parallel();
+        llvm::Value *gen_versioned();
+    public:
+        for_stmt(const std::string &, expr *, int, expr *,
+                std::list<reduction>, stmt *, int);
+        void set_parallel();
         llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
 class exit_stmt : public stmt {
     public:
         llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -444,8 +800,8 @@ class dec_stmt : public stmt {
         var_assign *var;
     public:
         dec_stmt(var_assign *);
-        virtual ~dec_stmt();
         llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -454,38 +810,57 @@ class inc_stmt : public stmt {
         var_assign *var;
     public:
         inc_stmt(var_assign *);
-        virtual ~inc_stmt();
         llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
 class readln_stmt : public stmt {
     protected:
-        var_assign *var;
+        std::list<var_assign *> vars;
     public:
-        readln_stmt(var_assign *);
-        virtual ~readln_stmt();
+        readln_stmt(std::list<var_assign *>);
         llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
 class write_stmt : public stmt {
     protected:
-        expr* expression;
+        std::list<expr *> exprs;
     public:
-        write_stmt(expr *);
-        virtual ~write_stmt();
+        write_stmt(std::list<expr *>);
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
 class writeln_stmt : public stmt {
     protected:
-        expr* expression;
+        std::list<expr *> exprs;
+    public:
+        writeln_stmt(std::list<expr *>);
+        virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
+        virtual void dump(int) const;
+};
+
+class spawn_stmt : public stmt {
+    protected:
+        var_assign *var;
+        const std::string name;
+        std::list<expr *> params;
+    public:
+        spawn_stmt(var_assign *, const std::string &, std::list<expr *>);
+        virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
+        virtual void dump(int) const;
+};
+
+class sync_stmt : public stmt {
     public:
-        writeln_stmt(expr *);
-        virtual ~writeln_stmt();
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
@@ -493,11 +868,13 @@ class break_stmt : public stmt {
     public:
         break_stmt();
         virtual llvm::Value *gen_ir();
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
 class null_stmt : public stmt {
     public:
+        virtual void deps(loop_info &) const;
         virtual void dump(int) const;
 };
 
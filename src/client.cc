@@ -0,0 +1,16 @@
+#include <cstdlib>
+#include <iostream>
+#include "server.h"
+
+/*
+ * Client of compile server started by llvm-sfe -server SOCKET. Arguments
+ * after socket are the same as arguments of llvm-sfe.
+ */
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cout << "usage: sfe-client SOCKET [-c] [options] file [args]"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    return request(argv[1], argc - 2, argv + 2);
+}
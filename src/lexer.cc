@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lexer.h"
+
+long int yynumbval;
+double yyrealval;
+int yyline = 1;
+
+/* keywords, looked up by hash of identifier */
+struct keyword {
+    const char *name;
+    int symb;
+};
+
+static const keyword keywords[] = {
+    {"array", LEX_ARRAY},
+    {"begin", LEX_BEGIN},
+    {"boolean", LEX_BOOL},
+    {"break", LEX_BRK},
+    {"byte", LEX_BYTE},
+    {"const", LEX_CONST},
+    {"dec", LEX_DEC},
+    {"do", LEX_DO},
+    {"downto", LEX_DOWNTO},
+    {"else", LEX_ELSE},
+    {"end", LEX_END},
+    {"exit", LEX_EXIT},
+    {"false", LEX_FALSE},
+    {"for", LEX_FOR},
+    {"forward", LEX_FORW},
+    {"function", LEX_FUNC},
+    {"inc", LEX_INC},
+    {"if", LEX_IF},
+    {"integer", LEX_INT},
+    {"longint", LEX_LONGINT},
+    {"of", LEX_OF},
+    {"packed", LEX_PACKED},
+    {"parallel", LEX_PARALLEL},
+    {"procedure", LEX_PROC},
+    {"program", LEX_PROGRAM},
+    {"readln", LEX_READLN},
+    {"real", LEX_REAL},
+    {"reduce", LEX_REDUCE},
+    {"shortint", LEX_SHORTINT},
+    {"smallint", LEX_SMALLINT},
+    {"spawn", LEX_SPAWN},
+    {"sync", LEX_SYNC},
+    {"then", LEX_THEN},
+    {"to", LEX_TO},
+    {"true", LEX_TRUE},
+    {"unit", LEX_UNIT},
+    {"uses", LEX_USES},
+    {"var", LEX_VAR},
+    {"while", LEX_WHILE},
+    {"word", LEX_WORD},
+    {"write", LEX_WRITE},
+    {"writeln", LEX_WRITELN},
+    {"div", LEX_DIV},
+    {"mod", LEX_MOD},
+    {"and", LEX_AND},
+    {"not", LEX_NOT},
+    {"or", LEX_OR}
+};
+
+/* open addressing table of indexes to keywords, -1 is empty slot */
+static const size_t KEYWORD_SLOTS = 128;
+
+static const int *keyword_table() {
+    static int table[KEYWORD_SLOTS];
+    static bool init = false;
+    if (!init) {
+        for (auto &t : table)
+            t = -1;
+        for (size_t k = 0; k < sizeof(keywords) / sizeof(keywords[0]); ++k) {
+            auto n = keywords[k].name;
+            auto i = yyhash(n, std::strlen(n)) % KEYWORD_SLOTS;
+            while (table[i] != -1)
+                i = (i + 1) % KEYWORD_SLOTS;
+            table[i] = k;
+        }
+        init = true;
+    }
+    return table;
+}
+
+static bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int digit_value(char c) {
+    if (is_digit(c))
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return 16;
+}
+
+/*
+ * Regular file is mapped whole, other input such as pipe is read to
+ * string.
+ */
+yyLexer::yyLexer(const char *file) {
+    auto fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return;
+    opened = true;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        auto p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            buf = static_cast<const char *>(p);
+            size = st.st_size;
+            mapped = true;
+        }
+    }
+    if (!mapped) {
+        char b[1 << 16];
+        ssize_t n;
+        while ((n = read(fd, b, sizeof(b))) > 0)
+            copy.append(b, n);
+        buf = copy.data();
+        size = copy.size();
+    }
+    close(fd);
+    pos = buf;
+    end = buf + size;
+}
+
+yyLexer::~yyLexer() {
+    if (mapped)
+        munmap(const_cast<char *>(buf), size);
+}
+
+bool yyLexer::good() const {
+    return opened;
+}
+
+const char *yyLexer::YYText() const {
+    return tok;
+}
+
+size_t yyLexer::YYLeng() const {
+    return len;
+}
+
+uint64_t yyLexer::YYHash() const {
+    return hash;
+}
+
+/*
+ * Decimal, hexadecimal after $ or octal after & integer, or real with
+ * fraction or exponent. Digits followed by .. are integer of range.
+ * Decimal integer does not start with 0, 012 is 0 followed by 12.
+ */
+int yyLexer::number(const char *p) {
+    if (*tok == '$' || *tok == '&') {
+        auto base = *tok == '$' ? 16 : 8;
+        unsigned long v = 0;
+        for (; p != end && digit_value(*p) < base; ++p)
+            v = v * base + digit_value(*p);
+        if (p == tok + 1) {
+            std::printf("Unrecognized character: %c\n", *tok);
+            pos = p;
+            return yylex();
+        }
+        pos = p;
+        len = p - tok;
+        yynumbval = v;
+        return LEX_NUMB;
+    }
+    unsigned long v = 0;
+    for (p = tok; p != end && is_digit(*p); ++p)
+        v = v * 10 + (*p - '0');
+    auto real = false;
+    if (p + 1 < end && *p == '.' && is_digit(p[1])) {
+        real = true;
+        for (++p; p != end && is_digit(*p); ++p)
+            ;
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        auto q = p + 1;
+        if (q != end && (*q == '+' || *q == '-'))
+            ++q;
+        if (q != end && is_digit(*q)) {
+            real = true;
+            for (p = q; p != end && is_digit(*p); ++p)
+                ;
+        }
+    }
+    if (!real && *tok == '0') {
+        p = tok + 1;
+        v = 0;
+    }
+    pos = p;
+    len = p - tok;
+    if (!real) {
+        yynumbval = v;
+        return LEX_NUMB;
+    }
+    char s[64];
+    auto n = std::min(len, sizeof(s) - 1);
+    std::memcpy(s, tok, n);
+    s[n] = '\0';
+    yyrealval = std::strtod(s, nullptr);
+    return LEX_REALNUMB;
+}
+
+/*
+ * Identifier is hashed once, the hash finds keyword in table and is kept
+ * for symbol table.
+ */
+int yyLexer::word(const char *p) {
+    for (; p != end && (is_alpha(*p) || is_digit(*p)); ++p)
+        ;
+    pos = p;
+    len = p - tok;
+    hash = yyhash(tok, len);
+    auto table = keyword_table();
+    for (auto i = hash % KEYWORD_SLOTS; table[i] != -1;
+            i = (i + 1) % KEYWORD_SLOTS) {
+        auto &k = keywords[table[i]];
+        if (std::strncmp(k.name, tok, len) == 0 && k.name[len] == '\0')
+            return k.symb;
+    }
+    return LEX_IDENT;
+}
+
+int yyLexer::yylex() {
+    for (;;) {
+        while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\n'
+                    || *pos == '\r')) {
+            if (*pos == '\n')
+                ++yyline;
+            ++pos;
+        }
+        tok = pos;
+        len = 1;
+        if (pos == end) {
+            len = 0;
+            return LEX_EOI;
+        }
+        auto c = *pos++;
+        auto next = pos != end ? *pos : '\0';
+        if (is_alpha(c))
+            return word(pos);
+        if (is_digit(c) || c == '$' || c == '&')
+            return number(pos);
+        switch (c) {
+            case '*':
+                if (next == '*') {
+                    ++pos;
+                    len = 2;
+                    return LEX_EXP;
+                }
+                return LEX_MUL;
+            case '-':
+                return LEX_MINUS;
+            case '/':
+                return LEX_SLASH;
+            case '+':
+                return LEX_PLUS;
+            case ':':
+                if (next == '=') {
+                    ++pos;
+                    len = 2;
+                    return LEX_ASSIGN;
+                }
+                return LEX_COLON;
+            case '=':
+                return LEX_EQ;
+            case '<':
+                if (next == '>' || next == '=') {
+                    ++pos;
+                    len = 2;
+                    return next == '>' ? LEX_NE : LEX_LE;
+                }
+                return LEX_LT;
+            case '>':
+                if (next == '=') {
+                    ++pos;
+                    len = 2;
+                    return LEX_GE;
+                }
+                return LEX_GT;
+            case ',':
+                return LEX_COMMA;
+            case '.':
+                if (next == '.') {
+                    ++pos;
+                    len = 2;
+                    return LEX_DOTDOT;
+                }
+                return LEX_DOT;
+            case '[':
+                return LEX_LBRAC;
+            case ']':
+                return LEX_RBRAC;
+            case '(':
+                return LEX_LRBRAC;
+            case ')':
+                return LEX_RRBRAC;
+            case ';':
+                return LEX_SEMICOLON;
+            default:
+                std::printf("Unrecognized character: %c\n", c);
+        }
+    }
+}
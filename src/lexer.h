@@ -1,12 +1,20 @@
 #ifndef lexer_h_k28xi1odj37cu2jg
 #define lexer_h_k28xi1odj37cu2jg
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
 extern long int yynumbval;
+extern double yyrealval;
+extern int yyline;
 
 enum lexsymb {
     LEX_ARRAY,
     LEX_BEGIN,
+    LEX_BOOL,
     LEX_BRK,
+    LEX_BYTE,
     LEX_CONST,
     LEX_DEC,
     LEX_DO,
@@ -14,20 +22,34 @@ enum lexsymb {
     LEX_ELSE,
     LEX_END,
     LEX_EXIT,
+    LEX_FALSE,
     LEX_FOR,
     LEX_FORW,
     LEX_FUNC,
     LEX_IF,
     LEX_INC,
     LEX_INT,
+    LEX_LONGINT,
     LEX_OF,
+    LEX_PACKED,
+    LEX_PARALLEL,
     LEX_PROC,
     LEX_PROGRAM,
     LEX_READLN,
+    LEX_REAL,
+    LEX_REDUCE,
+    LEX_SHORTINT,
+    LEX_SMALLINT,
+    LEX_SPAWN,
+    LEX_SYNC,
     LEX_THEN,
     LEX_TO,
+    LEX_TRUE,
+    LEX_UNIT,
+    LEX_USES,
     LEX_VAR,
     LEX_WHILE,
+    LEX_WORD,
     LEX_WRITE,
     LEX_WRITELN,
     LEX_DIV,
@@ -35,6 +57,7 @@ enum lexsymb {
     LEX_MINUS,
     LEX_MOD,
     LEX_MUL,
+    LEX_SLASH,
     LEX_PLUS,
     LEX_ASSIGN,
     LEX_EQ,
@@ -56,8 +79,51 @@ enum lexsymb {
     LEX_LRBRAC,
     LEX_RRBRAC,
     LEX_NUMB,
+    LEX_REALNUMB,
     LEX_SEMICOLON,
     LEX_EOI
 };
 
+/*
+ * yyhash
+ * FNV-1a hash of identifier, lexer computes it while scanning.
+ */
+inline uint64_t yyhash(const char *s, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; ++i)
+        h = (h ^ static_cast<unsigned char>(s[i])) * 1099511628211ull;
+    return h;
+}
+
+/*
+ * yyLexer class
+ * Tokens of source file mapped to memory. Text of token points into the
+ * mapping and is valid while lexer lives, identifiers carry their hash.
+ */
+class yyLexer {
+    private:
+        const char *buf = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        bool opened = false;
+        std::string copy;
+        const char *pos = nullptr;
+        const char *end = nullptr;
+        const char *tok = nullptr;
+        size_t len = 0;
+        uint64_t hash = 0;
+        int number(const char *);
+        int word(const char *);
+    public:
+        yyLexer(const char *);
+        yyLexer(const yyLexer &) = delete;
+        yyLexer &operator=(const yyLexer &) = delete;
+        ~yyLexer();
+        bool good() const;
+        int yylex();
+        const char *YYText() const;
+        size_t YYLeng() const;
+        uint64_t YYHash() const;
+};
+
 #endif /* lexer_h_k28xi1odj37cu2jg */
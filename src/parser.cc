@@ -1,12 +1,15 @@
-#include <fstream>
+#include <iostream>
 #include <stdexcept>
-#include <FlexLexer.h>
 #include "lexer.h"
 #include "parser.h"
 #include "ast.h"
 
-yyParser::yyParser(std::ifstream *in)
-    : yylexer{in} {}
+yyParser::yyParser(const char *file)
+    : yylexer{file} {}
+
+bool yyParser::good() const {
+    return yylexer.good();
+}
 
 ast::node *yyParser::yyparse() {
     yylexsymb = yylexer.yylex();
@@ -23,17 +26,73 @@ void yyParser::match(int symb) {
         std::cout << "match error" << std::endl;
 }
 
-std::string yyParser::get_ident() {
-    return std::string(yylexer.YYText(), yylexer.YYLeng());
+/* name of unit, empty for program */
+const std::string &yyParser::get_unit() const {
+    return unit_name;
+}
+
+const std::vector<std::string> &yyParser::get_uses() const {
+    return uses;
+}
+
+/*
+ * name of identifier interned with hash from lexer, repeated names are
+ * not copied
+ */
+const std::string &yyParser::get_ident() {
+    return ast::symbol_name(ast::intern(yylexer.YYText(), yylexer.YYLeng(),
+                yylexer.YYHash()));
 }
 
 ast::node *yyParser::program() {
-    match(LEX_PROGRAM);
+    switch (yylexsymb) {
+        case LEX_PROGRAM: {
+            yylexsymb = yylexer.yylex();
+            match(LEX_IDENT);
+            match(LEX_SEMICOLON);
+            uses_clause();
+            auto b = block();
+            match(LEX_DOT);
+            return b;
+        }
+        case LEX_UNIT:
+            return unit();
+        default:
+            std::cout << "program error" << std::endl;
+            return nullptr;
+    }
+}
+
+/*
+ * unit exports its constants, procedures and functions, its interface
+ * file is unit of the same syntax with forward declarations only
+ */
+ast::decl_list *yyParser::unit() {
+    match(LEX_UNIT);
+    if (yylexsymb == LEX_IDENT)
+        unit_name = get_ident();
     match(LEX_IDENT);
     match(LEX_SEMICOLON);
-    auto b = block();
+    uses_clause();
+    auto l = new ast::decl_list{};
+    while (yylexsymb == LEX_CONST || yylexsymb == LEX_PROC
+            || yylexsymb == LEX_FUNC)
+        l->add(def_or_decl());
+    match(LEX_END);
     match(LEX_DOT);
-    return b;
+    return l;
+}
+
+void yyParser::uses_clause() {
+    if (yylexsymb != LEX_USES)
+        return;
+    do {
+        yylexsymb = yylexer.yylex();
+        if (yylexsymb == LEX_IDENT)
+            uses.push_back(get_ident());
+        match(LEX_IDENT);
+    } while (yylexsymb == LEX_COMMA);
+    match(LEX_SEMICOLON);
 }
 
 ast::block *yyParser::block() {
@@ -42,17 +101,11 @@ ast::block *yyParser::block() {
 }
 
 ast::decl_list *yyParser::def_and_decl_list() {
-    switch (yylexsymb) {
-        case LEX_CONST:
-        case LEX_VAR:
-        case LEX_PROC:
-        case LEX_FUNC: {
-            auto l = def_or_decl();
-            return new ast::decl_list{l, def_and_decl_list()};
-        }
-        default:
-            return new ast::null_decl_list{};
-    }
+    auto l = new ast::decl_list{};
+    while (yylexsymb == LEX_CONST || yylexsymb == LEX_VAR
+            || yylexsymb == LEX_PROC || yylexsymb == LEX_FUNC)
+        l->add(def_or_decl());
+    return l;
 }
 
 ast::decl *yyParser::def_or_decl() {
@@ -73,19 +126,15 @@ ast::decl *yyParser::def_or_decl() {
 
 ast::decl_list *yyParser::const_def_part() {
     match(LEX_CONST);
-    auto d = const_def();
-    return new ast::decl_list{d, const_list()};
+    auto l = new ast::decl_list{};
+    l->add(const_def());
+    const_list(l);
+    return l;
 }
 
-ast::decl_list *yyParser::const_list() {
-    switch (yylexsymb) {
-        case LEX_IDENT: {
-            auto d = const_def();
-            return new ast::decl_list{d, const_list()};
-        }
-        default:
-            return new ast::null_decl_list{};
-    }
+void yyParser::const_list(ast::decl_list *l) {
+    while (yylexsymb == LEX_IDENT)
+        l->add(const_def());
 }
 
 ast::decl *yyParser::const_def() {
@@ -96,6 +145,7 @@ ast::decl *yyParser::const_def() {
             match(LEX_EQ);
             auto v = constant();
             match(LEX_SEMICOLON);
+            consts[n] = v;
             return new ast::const_decl{n, v};
         }
         default:
@@ -104,7 +154,7 @@ ast::decl *yyParser::const_def() {
     }
 }
 
-int yyParser::constant() {
+long int yyParser::constant() {
     switch (yylexsymb) {
         case LEX_NUMB:
             yylexsymb = yylexer.yylex();
@@ -117,6 +167,16 @@ int yyParser::constant() {
             yylexsymb = yylexer.yylex();
             match(LEX_NUMB);
             return -yynumbval;
+        case LEX_IDENT: {
+            /* bounds of arrays may name an earlier constant */
+            auto c = consts.find(get_ident());
+            if (c != consts.end()) {
+                yylexsymb = yylexer.yylex();
+                return c->second;
+            }
+            std::cout << "constant error" << std::endl;
+            return -1;
+        }
         default:
             std::cout << "constant error" << std::endl;
             return -1;
@@ -125,20 +185,17 @@ int yyParser::constant() {
 
 ast::decl_list *yyParser::var_decl_part() {
     match(LEX_VAR);
-    auto l = var_decl();
+    auto l = new ast::decl_list{};
+    l->add(var_decl());
     match(LEX_SEMICOLON);
-    return new ast::decl_list{l, var_decl_list()};
+    var_decl_list(l);
+    return l;
 }
 
-ast::decl_list *yyParser::var_decl_list() {
-    switch (yylexsymb) {
-        case LEX_IDENT: {
-            auto l = var_decl();
-            match(LEX_SEMICOLON);
-            return new ast::decl_list{l, var_decl_list()};
-        }
-        default:
-            return new ast::null_decl_list{};
+void yyParser::var_decl_list(ast::decl_list *l) {
+    while (yylexsymb == LEX_IDENT) {
+        l->add(var_decl());
+        match(LEX_SEMICOLON);
     }
 }
 
@@ -153,37 +210,58 @@ ast::decl_list *yyParser::var_decl() {
 ast::decl_list *yyParser::ident_list() {
     auto n = get_ident(); 
     match(LEX_IDENT);
-    return new ast::var_decl_list{new ast::var_decl{n}, ident_list_0()};
+    auto l = new ast::var_decl_list{};
+    l->add(new ast::var_decl{n});
+    ident_list_0(l);
+    return l;
 }
 
-ast::decl_list *yyParser::ident_list_0() {
-    switch (yylexsymb) {
-        case LEX_COMMA: {
-            yylexsymb = yylexer.yylex();
-            auto n = get_ident();
-            match(LEX_IDENT);
-            return new ast::var_decl_list{new ast::var_decl{n}, ident_list_0()};
-        }
-        default:
-            return new ast::null_decl_list{};
+void yyParser::ident_list_0(ast::decl_list *l) {
+    while (yylexsymb == LEX_COMMA) {
+        yylexsymb = yylexer.yylex();
+        auto n = get_ident();
+        match(LEX_IDENT);
+        l->add(new ast::var_decl{n});
     }
 }
 
 std::shared_ptr<ast::type> yyParser::type() {
     switch (yylexsymb) {
         case LEX_INT:
-            yylexsymb = yylexer.yylex();
-            return std::make_shared<ast::int_type>();
+        case LEX_LONGINT:
+        case LEX_SMALLINT:
+        case LEX_SHORTINT:
+        case LEX_WORD:
+        case LEX_BYTE:
+        case LEX_BOOL:
+        case LEX_REAL:
+            return simple_type();
+        case LEX_PACKED: {
+            yylexsymb = yylexer.yylex();
+            match(LEX_ARRAY);
+            match(LEX_LBRAC);
+            auto b = std::vector<std::pair<long int, long int>>{
+                index_range()};
+            index_range_0(b);
+            match(LEX_RBRAC);
+            match(LEX_OF);
+            match(LEX_BOOL);
+            return std::make_shared<ast::packed_array_type>(b);
+        }
         case LEX_ARRAY: {
             yylexsymb = yylexer.yylex();
+            if (yylexsymb == LEX_OF) {
+                /* open array parameter */
+                yylexsymb = yylexer.yylex();
+                return std::make_shared<ast::open_array_type>(simple_type());
+            }
             match(LEX_LBRAC);
-            auto f = constant();
-            match(LEX_DOTDOT);
-            auto t = constant();
+            auto b = std::vector<std::pair<long int, long int>>{
+                index_range()};
+            index_range_0(b);
             match(LEX_RBRAC);
             match(LEX_OF);
-            match(LEX_INT);
-            return std::make_shared<ast::array_type>(f, t);
+            return std::make_shared<ast::array_type>(b, simple_type());
         }
         default:
             std::cout << "type error" << std::endl;
@@ -191,6 +269,52 @@ std::shared_ptr<ast::type> yyParser::type() {
     }
 }
 
+std::shared_ptr<ast::type> yyParser::simple_type() {
+    auto t = yylexsymb;
+    yylexsymb = yylexer.yylex();
+    switch (t) {
+        case LEX_INT:
+            return std::make_shared<ast::int_type>();
+        case LEX_LONGINT:
+            return std::make_shared<ast::int_type>(32, true);
+        case LEX_SMALLINT:
+            return std::make_shared<ast::int_type>(16, true);
+        case LEX_SHORTINT:
+            return std::make_shared<ast::int_type>(8, true);
+        case LEX_WORD:
+            return std::make_shared<ast::int_type>(16, false);
+        case LEX_BYTE:
+            return std::make_shared<ast::int_type>(8, false);
+        case LEX_BOOL:
+            return std::make_shared<ast::bool_type>();
+        case LEX_REAL:
+            return std::make_shared<ast::real_type>();
+        default:
+            std::cout << "simple_type error" << std::endl;
+            return nullptr;
+    }
+}
+
+std::pair<long int, long int> yyParser::index_range() {
+    auto f = constant();
+    match(LEX_DOTDOT);
+    auto t = constant();
+    return std::make_pair(f, t);
+}
+
+void yyParser::index_range_0(
+        std::vector<std::pair<long int, long int>> &b) {
+    switch (yylexsymb) {
+        case LEX_COMMA:
+            yylexsymb = yylexer.yylex();
+            b.push_back(index_range());
+            index_range_0(b);
+            return;
+        default:
+            return;
+    }
+}
+
 ast::decl *yyParser::proc_decl() {
     match(LEX_PROC);
     auto n = get_ident();
@@ -205,7 +329,7 @@ ast::proc_decl *yyParser::proc_decl_0(const std:: string &n) {
         case LEX_SEMICOLON: {
             yylexsymb = yylexer.yylex();
             auto b = proc_decl_1();
-            return new ast::proc_decl{n, std::list<std::string>{}, b};
+            return new ast::proc_decl{n, std::list<ast::param>{}, b};
         }
         case LEX_LRBRAC: {
             auto f = formal_param_list();
@@ -250,18 +374,18 @@ ast::func_decl *yyParser::func_decl_0(const std::string &n) {
     switch (yylexsymb) {
         case LEX_COLON: {
             yylexsymb = yylexer.yylex();
-            match(LEX_INT);
+            auto t = simple_type();
             match(LEX_SEMICOLON);
             auto b = func_decl_1();
-            return new ast::func_decl{n, std::list<std::string>{}, b};
+            return new ast::func_decl{n, std::list<ast::param>{}, t, b};
         }
         case LEX_LRBRAC: {
             auto f = formal_param_list();
             match(LEX_COLON);
-            match(LEX_INT);
+            auto t = simple_type();
             match(LEX_SEMICOLON);
             auto b = func_decl_1();
-            return new ast::func_decl{n, f, b};
+            return new ast::func_decl{n, f, t, b};
         }
         default:
             std::cout << "func_decl_0 error" << std::endl;
@@ -287,21 +411,21 @@ ast::block *yyParser::func_decl_1() {
     }
 }
 
-std::list<std::string> yyParser::formal_param_list() {
+std::list<ast::param> yyParser::formal_param_list() {
     match(LEX_LRBRAC);
     auto l = formal_param_sec_list();
     match(LEX_RRBRAC);
     return l;
 }
 
-std::list<std::string> yyParser::formal_param_sec_list() {
-    auto l = std::list<std::string>{};
+std::list<ast::param> yyParser::formal_param_sec_list() {
+    auto l = std::list<ast::param>{};
     formal_param_sec(l);
     formal_param_sec_list_0(l);
     return l;
 }
 
-void yyParser::formal_param_sec_list_0(std::list<std::string> &l) {
+void yyParser::formal_param_sec_list_0(std::list<ast::param> &l) {
     switch (yylexsymb) {
         case LEX_SEMICOLON:
             yylexsymb = yylexer.yylex();
@@ -313,11 +437,14 @@ void yyParser::formal_param_sec_list_0(std::list<std::string> &l) {
     }
 }
 
-void yyParser::formal_param_sec(std::list<std::string> &l) {
-    l.push_back(get_ident());
+void yyParser::formal_param_sec(std::list<ast::param> &l) {
+    auto r = yylexsymb == LEX_VAR;
+    if (r)
+        yylexsymb = yylexer.yylex();
+    auto n = get_ident();
     yylexsymb = yylexer.yylex();
     match(LEX_COLON);
-    type();
+    l.push_back(ast::param{n, type(), r});
 }
 
 ast::compound_stmt *yyParser::comp_stmt() {
@@ -328,19 +455,16 @@ ast::compound_stmt *yyParser::comp_stmt() {
 }
 
 ast::stmt_list *yyParser::stmt_seq() {
-    auto s = stmt();
-    return new ast::stmt_list{s, stmt_seq_0()};
+    auto l = new ast::stmt_list{};
+    l->add(stmt());
+    stmt_seq_0(l);
+    return l;
 }
 
-ast::stmt_list *yyParser::stmt_seq_0() {
-    switch (yylexsymb) {
-        case LEX_SEMICOLON: {
-            yylexsymb = yylexer.yylex();
-            auto s = stmt();
-            return new ast::stmt_list{s, stmt_seq_0()};
-        }
-        default:
-            return new ast::null_stmt_list{};
+void yyParser::stmt_seq_0(ast::stmt_list *l) {
+    while (yylexsymb == LEX_SEMICOLON) {
+        yylexsymb = yylexer.yylex();
+        l->add(stmt());
     }
 }
 
@@ -379,35 +503,48 @@ ast::stmt *yyParser::stmt() {
         case LEX_READLN: {
             yylexsymb = yylexer.yylex();
             match(LEX_LRBRAC);
-            auto n = get_ident();
-            match(LEX_IDENT);
-            auto v = new ast::var_assign{n};
-            var_assign(v);
+            auto l = std::list<ast::var_assign *>{readln_var()};
+            readln_list_0(l);
             match(LEX_RRBRAC);
-            return new ast::readln_stmt{v};
+            return new ast::readln_stmt{std::move(l)};
         }
         case LEX_WRITELN: {
             yylexsymb = yylexer.yylex();
             match(LEX_LRBRAC);
-            auto e = expr();
+            auto l = actual_param_list();
             match(LEX_RRBRAC);
-            return new ast::writeln_stmt{e};
+            return new ast::writeln_stmt{std::move(l)};
         }
         case LEX_WRITE: {
             yylexsymb = yylexer.yylex();
             match(LEX_LRBRAC);
-            auto e = expr();
+            auto l = actual_param_list();
             match(LEX_RRBRAC);
-            return new ast::write_stmt{e};
+            return new ast::write_stmt{std::move(l)};
         }
         case LEX_BRK: {
             yylexsymb = yylexer.yylex();
             return new ast::break_stmt{};
         }
+        case LEX_SPAWN: {
+            yylexsymb = yylexer.yylex();
+            auto n = get_ident();
+            match(LEX_IDENT);
+            return spawn_stmt(n);
+        }
+        case LEX_SYNC:
+            yylexsymb = yylexer.yylex();
+            return new ast::sync_stmt{};
         case LEX_WHILE:
             return while_stmt();
         case LEX_FOR:
             return for_stmt();
+        case LEX_PARALLEL: {
+            yylexsymb = yylexer.yylex();
+            auto f = for_stmt();
+            f->set_parallel();
+            return f;
+        }
         case LEX_IF:
             return if_stmt();
         default:
@@ -434,14 +571,43 @@ ast::stmt *yyParser::assign_or_proc_stmt(const std::string& n) {
     }
 }
 
-void yyParser::var_assign(ast::var_assign *v) {
+ast::spawn_stmt *yyParser::spawn_stmt(const std::string &n) {
     switch (yylexsymb) {
         case LEX_LBRAC:
+        case LEX_ASSIGN: {
+            auto v = new ast::var_assign{n};
+            var_assign(v);
+            auto f = get_ident();
+            match(LEX_IDENT);
+            match(LEX_LRBRAC);
+            auto l = actual_param_list();
+            match(LEX_RRBRAC);
+            return new ast::spawn_stmt{v, f, l};
+        }
+        case LEX_LRBRAC: {
             yylexsymb = yylexer.yylex();
-            v->add_idx(expr());
+            auto l = actual_param_list();
+            match(LEX_RRBRAC);
+            return new ast::spawn_stmt{nullptr, n, l};
+        }
+        default:
+            std::cout << "spawn_stmt error" << std::endl;
+            return nullptr;
+    }
+}
+
+void yyParser::var_assign(ast::var_assign *v) {
+    switch (yylexsymb) {
+        case LEX_LBRAC: {
+            yylexsymb = yylexer.yylex();
+            auto l = std::list<ast::expr *>{expr()};
+            idx_list_0(l);
+            for (auto e : l)
+                v->add_idx(e);
             match(LEX_RBRAC);
             var_assign(v);
             return;
+        }
         case LEX_ASSIGN:
             yylexsymb = yylexer.yylex();
             return;
@@ -450,6 +616,26 @@ void yyParser::var_assign(ast::var_assign *v) {
     }
 }
 
+ast::var_assign *yyParser::readln_var() {
+    auto n = get_ident();
+    match(LEX_IDENT);
+    auto v = new ast::var_assign{n};
+    var_assign(v);
+    return v;
+}
+
+void yyParser::readln_list_0(std::list<ast::var_assign *> &l) {
+    switch (yylexsymb) {
+        case LEX_COMMA:
+            yylexsymb = yylexer.yylex();
+            l.push_back(readln_var());
+            readln_list_0(l);
+            return;
+        default:
+            return;
+    }
+}
+
 ast::while_stmt *yyParser::while_stmt() {
     match(LEX_WHILE);
     auto e = expr();
@@ -458,6 +644,7 @@ ast::while_stmt *yyParser::while_stmt() {
 }
 
 ast::for_stmt *yyParser::for_stmt() {
+    auto line = yyline;
     match(LEX_FOR);
     auto n = get_ident();
     match(LEX_IDENT);
@@ -465,8 +652,57 @@ ast::for_stmt *yyParser::for_stmt() {
     auto f = expr();
     auto d = dir();
     auto t = expr();
+    auto r = std::list<ast::reduction>{};
+    reduce_list(r);
     match(LEX_DO);
-    return new ast::for_stmt{n, f, d, t, stmt()};
+    return new ast::for_stmt{n, f, d, t, r, stmt(), line};
+}
+
+void yyParser::reduce_list(std::list<ast::reduction> &l) {
+    switch (yylexsymb) {
+        case LEX_REDUCE: {
+            yylexsymb = yylexer.yylex();
+            match(LEX_LRBRAC);
+            auto op = reduce_op();
+            match(LEX_COLON);
+            auto n = get_ident();
+            match(LEX_IDENT);
+            match(LEX_RRBRAC);
+            l.push_back(ast::reduction{op, n});
+            reduce_list(l);
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+int yyParser::reduce_op() {
+    switch (yylexsymb) {
+        case LEX_AND:
+            yylexsymb = yylexer.yylex();
+            return ast::RED_AND;
+        case LEX_OR:
+            yylexsymb = yylexer.yylex();
+            return ast::RED_OR;
+        case LEX_IDENT: {
+            auto n = get_ident();
+            yylexsymb = yylexer.yylex();
+            if (n == "sum")
+                return ast::RED_SUM;
+            if (n == "product")
+                return ast::RED_PROD;
+            if (n == "min")
+                return ast::RED_MIN;
+            if (n == "max")
+                return ast::RED_MAX;
+            std::cout << "reduce_op error" << std::endl;
+            return -1;
+        }
+        default:
+            std::cout << "reduce_op error" << std::endl;
+            return -1;
+    }
 }
 
 ast::if_stmt *yyParser::if_stmt() {
@@ -501,107 +737,76 @@ int yyParser::dir() {
     }
 }
 
-ast::expr *yyParser::expr() {
-    return expr_0(simple_expr());
-}
-
-ast::expr *yyParser::expr_0(ast::expr *e) {
-    switch (yylexsymb) {
-        case LEX_EQ:
-            yylexsymb = yylexer.yylex();
-            return new ast::eq_expr{e, simple_expr()};
-        case LEX_NE:
-            yylexsymb = yylexer.yylex();
-            return new ast::ne_expr{e, simple_expr()};
-        case LEX_LT:
-            yylexsymb = yylexer.yylex();
-            return new ast::lt_expr{e, simple_expr()};
-        case LEX_GT:
-            yylexsymb = yylexer.yylex();
-            return new ast::gt_expr{e, simple_expr()};
-        case LEX_LE:
-            yylexsymb = yylexer.yylex();
-            return new ast::le_expr{e, simple_expr()};
-        case LEX_GE:
-            yylexsymb = yylexer.yylex();
-            return new ast::ge_expr{e, simple_expr()};
-        default:
-            return e;
+/*
+ * binary operators of expressions indexed by token, precedence 0 ends
+ * expression; relational operators do not associate and ** associates
+ * to the right
+ */
+enum {
+    PREC_REL = 1,
+    PREC_ADD,
+    PREC_MUL,
+    PREC_SIGN,
+    PREC_EXP
+};
+
+template<typename T>
+static ast::expr *make_binary(ast::expr *l, ast::expr *r) {
+    return new T{l, r};
+}
+
+struct binary_op {
+    int prec;
+    ast::expr *(*make)(ast::expr *, ast::expr *);
+};
+
+static const struct binary_op_table {
+    binary_op ops[LEX_EOI + 1];
+    binary_op_table() : ops{} {
+        ops[LEX_EQ] = {PREC_REL, make_binary<ast::eq_expr>};
+        ops[LEX_NE] = {PREC_REL, make_binary<ast::ne_expr>};
+        ops[LEX_LT] = {PREC_REL, make_binary<ast::lt_expr>};
+        ops[LEX_GT] = {PREC_REL, make_binary<ast::gt_expr>};
+        ops[LEX_LE] = {PREC_REL, make_binary<ast::le_expr>};
+        ops[LEX_GE] = {PREC_REL, make_binary<ast::ge_expr>};
+        ops[LEX_PLUS] = {PREC_ADD, make_binary<ast::add_expr>};
+        ops[LEX_MINUS] = {PREC_ADD, make_binary<ast::sub_expr>};
+        ops[LEX_OR] = {PREC_ADD, make_binary<ast::or_expr>};
+        ops[LEX_MUL] = {PREC_MUL, make_binary<ast::mul_expr>};
+        ops[LEX_DIV] = {PREC_MUL, make_binary<ast::div_expr>};
+        ops[LEX_SLASH] = {PREC_MUL, make_binary<ast::real_div_expr>};
+        ops[LEX_MOD] = {PREC_MUL, make_binary<ast::mod_expr>};
+        ops[LEX_AND] = {PREC_MUL, make_binary<ast::and_expr>};
+        ops[LEX_EXP] = {PREC_EXP, make_binary<ast::exp_expr>};
     }
-}
-
-ast::expr *yyParser::simple_expr() {
-    return simple_expr_0(term());
-}
+} binary_ops;
 
-ast::expr *yyParser::simple_expr_0(ast::expr *e) {
-    switch (yylexsymb) {
-        case LEX_PLUS:
-            yylexsymb = yylexer.yylex();
-            return simple_expr_0(new ast::add_expr{e, term()});
-        case LEX_MINUS:
-            yylexsymb = yylexer.yylex();
-            return simple_expr_0(new ast::sub_expr{e, term()});
-        case LEX_OR:
-            yylexsymb = yylexer.yylex();
-            return simple_expr_0(new ast::or_expr{e, term()});
-        default:
-            return e;
-    }
-}
-
-ast::expr *yyParser::term() {
-    return term_0(factor());
+ast::expr *yyParser::expr() {
+    return expr(PREC_REL);
 }
 
-ast::expr *yyParser::term_0(ast::expr *e) {
-    switch (yylexsymb) {
-        case LEX_MUL:
-            yylexsymb = yylexer.yylex();
-            return term_0(new ast::mul_expr{e, factor()});
-        case LEX_DIV:
-            yylexsymb = yylexer.yylex();
-            return term_0(new ast::div_expr{e, factor()});
-        case LEX_MOD:
-            yylexsymb = yylexer.yylex();
-            return term_0(new ast::mod_expr{e, factor()});
-        case LEX_AND:
-            yylexsymb = yylexer.yylex();
-            return term_0(new ast::and_expr{e, factor()});
-        default:
+/*
+ * precedence climbing, operators of equal precedence are folded in loop,
+ * recursion goes only one level deeper per higher precedence; sign binds
+ * weaker than ** and stronger than *, as factor of grammar
+ */
+ast::expr *yyParser::expr(int min) {
+    ast::expr *e;
+    if (min <= PREC_SIGN && yylexsymb == LEX_PLUS) {
+        yylexsymb = yylexer.yylex();
+        e = expr(PREC_SIGN);
+    } else if (min <= PREC_SIGN && yylexsymb == LEX_MINUS) {
+        yylexsymb = yylexer.yylex();
+        e = new ast::minus_expr{expr(PREC_SIGN)};
+    } else
+        e = primary();
+    for (;;) {
+        auto op = binary_ops.ops[yylexsymb];
+        if (op.prec < min || op.prec == 0)
             return e;
-    }
-}
-
-ast::expr *yyParser::factor() {
-    switch (yylexsymb) {
-        case LEX_PLUS:
-            yylexsymb = yylexer.yylex();
-            return factor();
-        case LEX_MINUS:
-            yylexsymb = yylexer.yylex();
-            return new ast::minus_expr{factor()};
-        case LEX_IDENT:
-        case LEX_NUMB:
-        case LEX_LRBRAC:
-        case LEX_NOT:
-            return exp();
-        default:
-            std::cout << "factor error" << std::endl;
-            return nullptr;
-    }
-}
-
-ast::expr *yyParser::exp() {
-    return exp_0(primary());
-}
-
-ast::expr *yyParser::exp_0(ast::expr *e) {
-    switch (yylexsymb) {
-        case LEX_EXP:
-            yylexsymb = yylexer.yylex();
-            return new ast::exp_expr{e, exp()};
-        default:
+        yylexsymb = yylexer.yylex();
+        e = op.make(e, expr(op.prec == PREC_EXP ? PREC_EXP : op.prec + 1));
+        if (op.prec == PREC_REL)
             return e;
     }
 }
@@ -616,6 +821,15 @@ ast::expr *yyParser::primary() {
         case LEX_NUMB:
             yylexsymb = yylexer.yylex();
             return new ast::numb{yynumbval};
+        case LEX_REALNUMB:
+            yylexsymb = yylexer.yylex();
+            return new ast::real_numb{yyrealval};
+        case LEX_TRUE:
+        case LEX_FALSE: {
+            auto v = yylexsymb == LEX_TRUE;
+            yylexsymb = yylexer.yylex();
+            return new ast::bool_const{v};
+        }
         case LEX_LRBRAC: {
             yylexsymb = yylexer.yylex();
             auto e = expr();
@@ -643,6 +857,7 @@ ast::expr *yyParser::primary_0(const std::string &n) {
         case LEX_EXP:
         case LEX_MUL:
         case LEX_DIV:
+        case LEX_SLASH:
         case LEX_MOD:
         case LEX_AND:
         case LEX_PLUS:
@@ -673,16 +888,32 @@ ast::expr *yyParser::primary_0(const std::string &n) {
 
 ast::expr *yyParser::var_access(ast::var_access *v) {
     switch (yylexsymb) {
-        case LEX_LBRAC:
+        case LEX_LBRAC: {
             yylexsymb = yylexer.yylex();
-            v->add_idx(expr());
+            auto l = std::list<ast::expr *>{expr()};
+            idx_list_0(l);
+            for (auto e : l)
+                v->add_idx(e);
             match(LEX_RBRAC);
             return var_access(v);
+        }
         default:
             return v;
     }
 }
 
+void yyParser::idx_list_0(std::list<ast::expr *> &l) {
+    switch (yylexsymb) {
+        case LEX_COMMA:
+            yylexsymb = yylexer.yylex();
+            l.push_back(expr());
+            idx_list_0(l);
+            return;
+        default:
+            return;
+    }
+}
+
 std::list<ast::expr *> yyParser::actual_param_list() {
     auto l = std::list<ast::expr *>{};
     l.push_back(expr());
@@ -1,70 +1,80 @@
 #ifndef parser_h_msj16e76apo2jy7i
 #define parser_h_msj16e76apo2jy7i
 
-#include <fstream>
+#include <map>
 #include <memory>
 #include <string>
-#include <FlexLexer.h>
+#include <vector>
 #include "lexer.h"
 #include "ast.h"
 
 class yyParser {
     public:
-        yyParser(std::ifstream *);
+        yyParser(const char *);
+        bool good() const;
         ast::node *yyparse();
+        const std::string &get_unit() const;
+        const std::vector<std::string> &get_uses() const;
     private:
-        yyFlexLexer yylexer;
+        yyLexer yylexer;
         int yylexsymb;
+        std::string unit_name;
+        std::vector<std::string> uses;
+        std::map<std::string, long int> consts;
         void match(int);
-        std::string get_ident();
+        const std::string &get_ident();
 
         ast::node *program();
+        ast::decl_list *unit();
+        void uses_clause();
         ast::block *block();
         ast::decl_list *def_and_decl_list();
         ast::decl *def_or_decl();
         ast::decl_list *const_def_part();
-        ast::decl_list *const_list();
+        void const_list(ast::decl_list *);
         ast::decl *const_def();
-        int constant();
+        long int constant();
         ast::decl_list *var_decl_part();
-        ast::decl_list *var_decl_list();
+        void var_decl_list(ast::decl_list *);
         ast::decl_list *var_decl();
         ast::decl_list *ident_list();
-        ast::decl_list *ident_list_0();
+        void ident_list_0(ast::decl_list *);
         std::shared_ptr<ast::type> type();
+        std::shared_ptr<ast::type> simple_type();
+        std::pair<long int, long int> index_range();
+        void index_range_0(std::vector<std::pair<long int, long int>> &);
         ast::decl *proc_decl();
         ast::proc_decl *proc_decl_0(const std::string &);
         ast::block *proc_decl_1();
         ast::decl *func_decl();
         ast::func_decl *func_decl_0(const std::string &);
         ast::block *func_decl_1();
-        std::list<std::string> formal_param_list();
-        std::list<std::string> formal_param_sec_list();
-        void formal_param_sec_list_0(std::list<std::string> &);
-        void formal_param_sec(std::list<std::string> &);
+        std::list<ast::param> formal_param_list();
+        std::list<ast::param> formal_param_sec_list();
+        void formal_param_sec_list_0(std::list<ast::param> &);
+        void formal_param_sec(std::list<ast::param> &);
         ast::compound_stmt *comp_stmt();
         ast::stmt_list *stmt_seq();
-        ast::stmt_list *stmt_seq_0();
+        void stmt_seq_0(ast::stmt_list *);
         ast::stmt *stmt();
         ast::stmt *assign_or_proc_stmt(const std::string &);
+        ast::spawn_stmt *spawn_stmt(const std::string &);
         void var_assign(ast::var_assign *);
+        ast::var_assign *readln_var();
+        void readln_list_0(std::list<ast::var_assign *> &);
         ast::while_stmt *while_stmt();
         ast::for_stmt *for_stmt();
+        void reduce_list(std::list<ast::reduction> &);
+        int reduce_op();
         ast::if_stmt *if_stmt();
         ast::stmt *else_stmt();
         int dir();
         ast::expr *expr();
-        ast::expr *expr_0(ast::expr *);
-        ast::expr *simple_expr();
-        ast::expr *simple_expr_0(ast::expr *);
-        ast::expr *term();
-        ast::expr *term_0(ast::expr *);
-        ast::expr *factor();
-        ast::expr *exp();
-        ast::expr *exp_0(ast::expr *);
+        ast::expr *expr(int);
         ast::expr *primary();
         ast::expr *primary_0(const std::string &);
         ast::expr *var_access(ast::var_access *);
+        void idx_list_0(std::list<ast::expr *> &);
         std::list<ast::expr *> actual_param_list();
         void actual_param_list_0(std::list<ast::expr *> &);
 };
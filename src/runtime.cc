@@ -0,0 +1,1012 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "runtime.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SFE_AVX2
+#endif
+
+/* smallest number of iterations worth moving to another thread */
+static const uint64_t MIN_CHUNK = 1024;
+
+/* chunks per thread, more chunks balance uneven iterations */
+static const uint64_t CHUNKS_PER_THREAD = 4;
+
+/* failed attempts to find task in sfe_sync before it starts to sleep */
+static const int SYNC_SPINS = 64;
+
+/* upper bound of worker and external threads using the scheduler */
+static const int MAX_WORKERS = 256;
+
+static std::mutex par_mutex;
+
+/*
+ * Read positive number from environment variable or return default.
+ */
+static int64_t env_number(const char *name, int64_t def) {
+    auto env = std::getenv(name);
+    if (env == nullptr)
+        return def;
+    return std::max(std::strtol(env, nullptr, 10), 1L);
+}
+
+/*
+ * Number of threads used by parallel loops and spawned calls. Environment
+ * variable SFE_THREADS overrides number of hardware threads.
+ */
+static int64_t thread_count() {
+    static const int64_t count = env_number("SFE_THREADS",
+            std::max(std::thread::hardware_concurrency(), 1u));
+    return count;
+}
+
+/*
+ * Spawned calls run inline once this many tasks wait in deque of the
+ * spawning thread, so recursion below the top levels is sequential.
+ * Environment variable SFE_SPAWN_CUTOFF overrides it.
+ */
+static int64_t spawn_cutoff() {
+    static const int64_t cutoff = env_number("SFE_SPAWN_CUTOFF",
+            4 * thread_count());
+    return cutoff;
+}
+
+/*
+ * task struct
+ * Copy of arguments of spawned call, counted in group of its spawner.
+ */
+struct task {
+    sfe_thunk fun;
+    int64_t *group;
+    int64_t *args;
+};
+
+static task *make_task(sfe_thunk f, const int64_t *a, int64_t n, int64_t *g) {
+    auto t = static_cast<task *>(std::malloc(sizeof(task) + n * sizeof(int64_t)));
+    t->fun = f;
+    t->group = g;
+    t->args = reinterpret_cast<int64_t *>(t + 1);
+    std::copy(a, a + n, t->args);
+    return t;
+}
+
+/*
+ * deque class
+ * Lock-free work-stealing deque of Chase and Lev with fixed capacity.
+ * The owner pushes and pops at the bottom, thieves steal from the top.
+ */
+class deque {
+    public:
+        static const int64_t CAPACITY = 1 << 13;
+        deque() : top{0}, bottom{0} {}
+        int64_t size() const;
+        bool push(task *);
+        task *pop();
+        task *steal();
+    private:
+        std::atomic<int64_t> top, bottom;
+        std::atomic<task *> buf[CAPACITY];
+};
+
+int64_t deque::size() const {
+    return bottom.load(std::memory_order_relaxed)
+        - top.load(std::memory_order_relaxed);
+}
+
+bool deque::push(task *t) {
+    auto b = bottom.load(std::memory_order_relaxed);
+    if (b - top.load(std::memory_order_acquire) >= CAPACITY)
+        return false;
+    buf[b & (CAPACITY - 1)].store(t, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+task *deque::pop() {
+    auto b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    auto x = buf[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        /* last task, race with thieves for it */
+        if (!top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed))
+            x = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return x;
+}
+
+task *deque::steal() {
+    auto t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return nullptr;
+    auto x = buf[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return x;
+}
+
+/*
+ * worker struct
+ * Deque of one thread, worker threads and threads running generated code
+ * alike.
+ */
+struct worker {
+    deque tasks;
+    uint64_t seed;
+};
+
+static worker *workers[MAX_WORKERS];
+static std::atomic<int> worker_count{0};
+static thread_local worker *self = nullptr;
+
+/* number of queued tasks, idle workers sleep while it is zero */
+static std::atomic<int64_t> queued{0};
+static std::atomic<int> sleepers{0};
+static std::mutex idle_mutex;
+static std::condition_variable idle_cv;
+
+static void worker_loop(worker *);
+
+/*
+ * Register calling thread with the scheduler, the first caller starts
+ * worker threads.
+ */
+static worker *current_worker() {
+    if (self != nullptr)
+        return self;
+    auto id = worker_count.fetch_add(1);
+    if (id >= MAX_WORKERS)
+        std::abort();
+    self = new worker{};
+    self->seed = id + 1;
+    workers[id] = self;
+    if (id == 0)
+        for (auto i = 1; i < thread_count(); ++i) {
+            auto w = new worker{};
+            auto wid = worker_count.fetch_add(1);
+            w->seed = wid + 1;
+            workers[wid] = w;
+            std::thread{worker_loop, w}.detach();
+        }
+    return self;
+}
+
+static bool submit(task *t) {
+    if (!self->tasks.push(t))
+        return false;
+    queued.fetch_add(1);
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock{idle_mutex};
+        idle_cv.notify_one();
+    }
+    return true;
+}
+
+/*
+ * Take task from own deque or steal one from random victim.
+ */
+static task *find_task(worker *w) {
+    auto t = w->tasks.pop();
+    auto n = worker_count.load();
+    for (auto i = 0; t == nullptr && i < n; ++i) {
+        /* xorshift */
+        w->seed ^= w->seed << 13;
+        w->seed ^= w->seed >> 7;
+        w->seed ^= w->seed << 17;
+        auto victim = workers[w->seed % n];
+        if (victim != nullptr && victim != w)
+            t = victim->tasks.steal();
+    }
+    if (t != nullptr)
+        queued.fetch_sub(1);
+    return t;
+}
+
+static void run(task *t) {
+    t->fun(t->args);
+    __atomic_fetch_sub(t->group, 1, __ATOMIC_RELEASE);
+    std::free(t);
+}
+
+static void worker_loop(worker *w) {
+    self = w;
+    for (;;) {
+        auto t = find_task(w);
+        if (t != nullptr) {
+            run(t);
+            continue;
+        }
+        /* queued is checked again under lock, timeout covers races */
+        std::unique_lock<std::mutex> lock{idle_mutex};
+        sleepers.fetch_add(1);
+        if (queued.load() == 0)
+            idle_cv.wait_for(lock, std::chrono::milliseconds(1));
+        sleepers.fetch_sub(1);
+    }
+}
+
+extern "C" int64_t sfe_spawn(sfe_thunk f, const int64_t *args, int64_t n,
+        int64_t *group) {
+    if (thread_count() == 1)
+        return 0;
+    auto w = current_worker();
+    if (w->tasks.size() >= spawn_cutoff())
+        return 0;
+    __atomic_fetch_add(group, 1, __ATOMIC_RELAXED);
+    auto t = make_task(f, args, n, group);
+    if (!submit(t)) {
+        __atomic_fetch_sub(group, 1, __ATOMIC_RELAXED);
+        std::free(t);
+        return 0;
+    }
+    return 1;
+}
+
+extern "C" void sfe_sync(int64_t *group) {
+    if (__atomic_load_n(group, __ATOMIC_ACQUIRE) == 0)
+        return;
+    auto w = current_worker();
+    auto idle = 0;
+    while (__atomic_load_n(group, __ATOMIC_ACQUIRE) != 0) {
+        auto t = find_task(w);
+        if (t != nullptr) {
+            run(t);
+            idle = 0;
+        } else if (++idle < SYNC_SPINS) {
+            std::this_thread::yield();
+        } else {
+            /* stolen tasks are still running, do not burn their core */
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+/*
+ * Chunk of parallel loop queued as task, arguments are body, ctx, lo, hi.
+ */
+static void run_chunk(int64_t *args) {
+    auto body = reinterpret_cast<sfe_body>(args[0]);
+    auto ctx = reinterpret_cast<void **>(args[1]);
+    body(ctx, args[2], args[3]);
+}
+
+extern "C" void sfe_par_for(sfe_body body, void **ctx, int64_t lo, int64_t hi) {
+    if (hi < lo)
+        return;
+    auto n = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo) + 1;
+    auto chunks = std::min<uint64_t>(thread_count() * CHUNKS_PER_THREAD,
+            (n + MIN_CHUNK - 1) / MIN_CHUNK);
+    if (thread_count() == 1 || chunks <= 1) {
+        body(ctx, lo, hi);
+        return;
+    }
+    current_worker();
+
+    /* first n % chunks chunks get one more iteration, the last one runs
+     * on this thread */
+    auto group = int64_t{0};
+    auto size = n / chunks;
+    auto extra = n % chunks;
+    auto start = lo;
+    for (uint64_t c = 0; c < chunks; ++c) {
+        auto end = start + static_cast<int64_t>(size + (c < extra) - 1);
+        int64_t args[] = {reinterpret_cast<int64_t>(body),
+            reinterpret_cast<int64_t>(ctx), start, end};
+        __atomic_fetch_add(&group, 1, __ATOMIC_RELAXED);
+        auto t = make_task(run_chunk, args, 4, &group);
+        if (c + 1 == chunks || !submit(t))
+            run(t);
+        start = end + 1;
+    }
+    sfe_sync(&group);
+}
+
+extern "C" void sfe_par_lock() {
+    par_mutex.lock();
+}
+
+extern "C" void sfe_par_unlock() {
+    par_mutex.unlock();
+}
+
+/* huge pages are 2 MiB on x86-64 */
+static const uintptr_t HUGE_PAGE = 1 << 21;
+
+/*
+ * Mark whole huge pages inside of range, kernel backs them by huge
+ * pages when it can.
+ */
+extern "C" void sfe_hugepages(void *p, int64_t bytes) {
+#ifdef MADV_HUGEPAGE
+    auto begin = (reinterpret_cast<uintptr_t>(p) + HUGE_PAGE - 1)
+        & ~(HUGE_PAGE - 1);
+    auto end = (reinterpret_cast<uintptr_t>(p) + bytes) & ~(HUGE_PAGE - 1);
+    if (begin < end)
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE);
+#endif
+}
+
+/*
+ * Runtime error ends program. Buffered output is written first, so the
+ * message follows everything the program printed.
+ */
+[[noreturn]] static void fail(const std::string &msg) {
+    sfe_flush();
+    std::fprintf(stderr, "%s\n", msg.c_str());
+    std::exit(EXIT_FAILURE);
+}
+
+/*
+ * Anonymous mapping is zeroed by kernel and its pages are touched only
+ * when used.
+ */
+extern "C" void *sfe_alloc_array(int64_t bytes, int64_t huge) {
+    auto p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        fail("cannot allocate array of " + std::to_string(bytes) + " bytes");
+    if (huge != 0)
+        sfe_hugepages(p, bytes);
+    return p;
+}
+
+extern "C" void sfe_free_array(void *p, int64_t bytes) {
+    munmap(p, bytes);
+}
+
+#ifdef SFE_AVX2
+/*
+ * Array kernels take 4 elements at once when processor has AVX2, other
+ * processors use the scalar loops.
+ */
+static bool has_avx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+__attribute__((target("avx2")))
+static __m256i load4(const int64_t *a) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+}
+
+__attribute__((target("avx2")))
+static void lanes(__m256i x, int64_t *l) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(l), x);
+}
+
+__attribute__((target("avx2")))
+static int64_t sum_avx2(const int64_t *a, int64_t n) {
+    auto s0 = _mm256_setzero_si256();
+    auto s1 = _mm256_setzero_si256();
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_add_epi64(s0, load4(a + i));
+        s1 = _mm256_add_epi64(s1, load4(a + i + 4));
+    }
+    int64_t l[4];
+    lanes(_mm256_add_epi64(s0, s1), l);
+    auto s = l[0] + l[1] + l[2] + l[3];
+    for (; i < n; ++i)
+        s += a[i];
+    return s;
+}
+
+__attribute__((target("avx2")))
+static int64_t max_avx2(const int64_t *a, int64_t n) {
+    auto m = _mm256_set1_epi64x(a[0]);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto x = load4(a + i);
+        m = _mm256_blendv_epi8(m, x, _mm256_cmpgt_epi64(x, m));
+    }
+    int64_t l[4];
+    lanes(m, l);
+    auto r = std::max(std::max(l[0], l[1]), std::max(l[2], l[3]));
+    for (; i < n; ++i)
+        r = std::max(r, a[i]);
+    return r;
+}
+
+__attribute__((target("avx2")))
+static int64_t min_avx2(const int64_t *a, int64_t n) {
+    auto m = _mm256_set1_epi64x(a[0]);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto x = load4(a + i);
+        m = _mm256_blendv_epi8(m, x, _mm256_cmpgt_epi64(m, x));
+    }
+    int64_t l[4];
+    lanes(m, l);
+    auto r = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+    for (; i < n; ++i)
+        r = std::min(r, a[i]);
+    return r;
+}
+
+/*
+ * equal lanes are all ones, subtracting them counts matches
+ */
+__attribute__((target("avx2")))
+static int64_t count_avx2(const int64_t *a, int64_t n, int64_t v) {
+    auto c = _mm256_setzero_si256();
+    auto x = _mm256_set1_epi64x(v);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        c = _mm256_sub_epi64(c, _mm256_cmpeq_epi64(load4(a + i), x));
+    int64_t l[4];
+    lanes(c, l);
+    auto r = l[0] + l[1] + l[2] + l[3];
+    for (; i < n; ++i)
+        r += a[i] == v;
+    return r;
+}
+
+/*
+ * scan inside register in two shifted additions, then add carry of
+ * previous elements
+ */
+__attribute__((target("avx2")))
+static void prefixsum_avx2(int64_t *a, int64_t n) {
+    auto zero = _mm256_setzero_si256();
+    auto carry = zero;
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto x = load4(a + i);
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(
+                    _mm256_permute4x64_epi64(x, 0x90), zero, 0x03));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(
+                    _mm256_permute4x64_epi64(x, 0x40), zero, 0x0f));
+        x = _mm256_add_epi64(x, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), x);
+        carry = _mm256_permute4x64_epi64(x, 0xff);
+    }
+    for (; i < n; ++i)
+        a[i] += i == 0 ? 0 : a[i - 1];
+}
+#endif
+
+extern "C" int64_t sfe_sum(const int64_t *a, int64_t n) {
+#ifdef SFE_AVX2
+    if (has_avx2())
+        return sum_avx2(a, n);
+#endif
+    int64_t s = 0;
+    for (int64_t i = 0; i < n; ++i)
+        s += a[i];
+    return s;
+}
+
+extern "C" int64_t sfe_max(const int64_t *a, int64_t n) {
+    /* empty open array, same identity as inlined loop */
+    if (n <= 0)
+        return INT64_MIN;
+#ifdef SFE_AVX2
+    if (has_avx2())
+        return max_avx2(a, n);
+#endif
+    auto r = a[0];
+    for (int64_t i = 1; i < n; ++i)
+        r = std::max(r, a[i]);
+    return r;
+}
+
+extern "C" int64_t sfe_min(const int64_t *a, int64_t n) {
+    /* empty open array, same identity as inlined loop */
+    if (n <= 0)
+        return INT64_MAX;
+#ifdef SFE_AVX2
+    if (has_avx2())
+        return min_avx2(a, n);
+#endif
+    auto r = a[0];
+    for (int64_t i = 1; i < n; ++i)
+        r = std::min(r, a[i]);
+    return r;
+}
+
+extern "C" int64_t sfe_count(const int64_t *a, int64_t n, int64_t v) {
+#ifdef SFE_AVX2
+    if (has_avx2())
+        return count_avx2(a, n, v);
+#endif
+    int64_t r = 0;
+    for (int64_t i = 0; i < n; ++i)
+        r += a[i] == v;
+    return r;
+}
+
+extern "C" void sfe_prefixsum(int64_t *a, int64_t n) {
+#ifdef SFE_AVX2
+    if (has_avx2()) {
+        prefixsum_avx2(a, n);
+        return;
+    }
+#endif
+    for (int64_t i = 1; i < n; ++i)
+        a[i] += a[i - 1];
+}
+
+/* output is written to stdout in blocks of this size */
+static const size_t OUT_SIZE = 1 << 16;
+
+/* longest decimal integer or formatted real with sign */
+static const size_t NUMBER_MAX = 32;
+
+static char out_buf[OUT_SIZE];
+static size_t out_len = 0;
+static std::mutex out_mutex;
+
+/*
+ * Write buffer in one call, caller holds out_mutex. Goes through stdio so
+ * it keeps order with messages of compiler.
+ */
+static void out_write() {
+    std::fwrite(out_buf, 1, out_len, stdout);
+    std::fflush(stdout);
+    out_len = 0;
+}
+
+/*
+ * Append characters to buffer with space for one more character after
+ * them, caller holds out_mutex.
+ */
+static void out_put(const char *s, size_t n) {
+    if (out_len + n + 1 > OUT_SIZE)
+        out_write();
+    std::copy(s, s + n, out_buf + out_len);
+    out_len += n;
+}
+
+/*
+ * Append number to buffer followed by optional newline, whole number is
+ * written at once even when parallel loops print.
+ */
+static void out_append(const char *s, size_t n, bool newline) {
+    std::lock_guard<std::mutex> lock{out_mutex};
+    out_put(s, n);
+    if (newline)
+        out_buf[out_len++] = '\n';
+}
+
+/*
+ * Decimal digits are produced from the end, two at a time from a table of
+ * pairs. Returns number of characters written before end.
+ */
+static size_t format_int(int64_t x, char *end) {
+    static const char pairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    auto p = end;
+    auto u = x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x);
+    while (u >= 100) {
+        auto d = (u % 100) * 2;
+        u /= 100;
+        *--p = pairs[d + 1];
+        *--p = pairs[d];
+    }
+    if (u >= 10) {
+        *--p = pairs[u * 2 + 1];
+        *--p = pairs[u * 2];
+    } else {
+        *--p = '0' + u;
+    }
+    if (x < 0)
+        *--p = '-';
+    return end - p;
+}
+
+static void print_int(int64_t x, bool newline) {
+    char s[NUMBER_MAX];
+    auto n = format_int(x, s + NUMBER_MAX);
+    out_append(s + NUMBER_MAX - n, n, newline);
+}
+
+static void print_real(double x, bool newline) {
+    char s[NUMBER_MAX];
+    auto n = std::snprintf(s, NUMBER_MAX, "%.15g", x);
+    out_append(s, n, newline);
+}
+
+extern "C" void sfe_print(int64_t x) {
+    print_int(x, false);
+}
+
+extern "C" void sfe_println(int64_t x) {
+    print_int(x, true);
+}
+
+extern "C" void sfe_print_real(double x) {
+    print_real(x, false);
+}
+
+extern "C" void sfe_println_real(double x) {
+    print_real(x, true);
+}
+
+/*
+ * Items are formatted straight into buffer under one lock, so the whole
+ * list stays together. Every value but the first is preceded by space.
+ */
+class out_list {
+    private:
+        bool first = true;
+        void put(char *p, size_t n) {
+            if (!first) {
+                *--p = ' ';
+                ++n;
+            }
+            first = false;
+            out_put(p, n);
+        }
+    public:
+        void add(int64_t x) {
+            char s[NUMBER_MAX];
+            auto n = format_int(x, s + NUMBER_MAX);
+            put(s + NUMBER_MAX - n, n);
+        }
+        void add(double x) {
+            char s[NUMBER_MAX + 1];
+            auto n = std::snprintf(s + 1, NUMBER_MAX, "%.15g", x);
+            put(s + 1, n);
+        }
+};
+
+template <typename T>
+static void out_elems(out_list &l, const void *a, int64_t n) {
+    auto p = static_cast<const T *>(a);
+    for (int64_t i = 0; i < n; ++i)
+        l.add(static_cast<int64_t>(p[i]));
+}
+
+static void out_array(out_list &l, int64_t kind, const void *a, int64_t n) {
+    if (kind & SFE_WRITE_PACKED) {
+        auto w = static_cast<const uint64_t *>(a);
+        for (int64_t i = 0; i < n; ++i)
+            l.add(static_cast<int64_t>((w[i >> 6] >> (i & 63)) & 1));
+        return;
+    }
+    if (kind & SFE_WRITE_REAL) {
+        auto p = static_cast<const double *>(a);
+        for (int64_t i = 0; i < n; ++i)
+            l.add(p[i]);
+        return;
+    }
+    auto u = (kind & SFE_WRITE_UNSIGNED) != 0;
+    switch (kind >> SFE_WRITE_SIZE_SHIFT) {
+        case 1:
+            return u ? out_elems<uint8_t>(l, a, n) : out_elems<int8_t>(l, a, n);
+        case 2:
+            return u ? out_elems<uint16_t>(l, a, n)
+                : out_elems<int16_t>(l, a, n);
+        case 4:
+            return u ? out_elems<uint32_t>(l, a, n)
+                : out_elems<int32_t>(l, a, n);
+        default:
+            return out_elems<int64_t>(l, a, n);
+    }
+}
+
+extern "C" void sfe_write(const int64_t *items, int64_t n, int64_t newline) {
+    std::lock_guard<std::mutex> lock{out_mutex};
+    out_list l;
+    for (int64_t i = 0; i < n; ++i, items += 3) {
+        auto kind = items[0];
+        if (kind & SFE_WRITE_ARRAY) {
+            out_array(l, kind, reinterpret_cast<const void *>(items[1]),
+                    items[2]);
+        } else if (kind & SFE_WRITE_REAL) {
+            double x;
+            std::memcpy(&x, &items[1], sizeof(x));
+            l.add(x);
+        } else {
+            l.add(items[1]);
+        }
+    }
+    if (newline != 0)
+        out_put("\n", 1);
+}
+
+extern "C" void sfe_flush() {
+    std::lock_guard<std::mutex> lock{out_mutex};
+    if (out_len != 0)
+        out_write();
+}
+
+/* input from pipe or terminal is read in blocks of this size */
+static const size_t IN_SIZE = 1 << 16;
+
+static char in_buf[IN_SIZE];
+static const char *in_pos = nullptr;
+static const char *in_end = nullptr;
+static bool in_mapped = false;
+static bool in_done = false;
+
+/*
+ * Regular file on standard input is mapped whole at first read, other
+ * input is read block by block. Output is flushed before read may block,
+ * so prompt is visible. Returns false at end of input.
+ */
+static bool in_fill() {
+    if (in_done)
+        return false;
+    if (in_pos == nullptr) {
+        struct stat st;
+        if (fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode)
+                && st.st_size > 0) {
+            auto p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE,
+                    STDIN_FILENO, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                in_pos = static_cast<const char *>(p);
+                in_end = in_pos + st.st_size;
+                in_mapped = true;
+                return true;
+            }
+        }
+    }
+    if (in_mapped) {
+        in_done = true;
+        return false;
+    }
+    sfe_flush();
+    auto n = read(STDIN_FILENO, in_buf, IN_SIZE);
+    while (n < 0 && errno == EINTR)
+        n = read(STDIN_FILENO, in_buf, IN_SIZE);
+    if (n <= 0) {
+        in_done = true;
+        return false;
+    }
+    in_pos = in_buf;
+    in_end = in_buf + n;
+    return true;
+}
+
+/*
+ * next character of input without consuming it, -1 at end
+ */
+static int in_peek() {
+    if (in_pos == in_end && !in_fill())
+        return -1;
+    return static_cast<unsigned char>(*in_pos);
+}
+
+static void in_skip_space() {
+    for (auto c = in_peek(); c == ' ' || c == '\t' || c == '\n'
+            || c == '\r' || c == '\f' || c == '\v'; c = in_peek())
+        ++in_pos;
+}
+
+/*
+ * rest of token which is not a number, so that reading loop advances
+ */
+static void in_skip_token() {
+    for (auto c = in_peek(); c != -1 && c != ' ' && c != '\t' && c != '\n'
+            && c != '\r' && c != '\f' && c != '\v'; c = in_peek())
+        ++in_pos;
+}
+
+/*
+ * Value of 8 decimal digits at p when all of them are digits. Digits are
+ * combined pairwise in one 64-bit word.
+ */
+static bool eight_digits(const char *p, uint64_t &v) {
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    if ((w & 0xf0f0f0f0f0f0f0f0) != 0x3030303030303030
+            || ((w + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0)
+            != 0x3030303030303030)
+        return false;
+    w -= 0x3030303030303030;
+    w = w * 10 + (w >> 8);
+    v = (((w & 0x000000ff000000ff) * 0x000f424000000064)
+            + (((w >> 16) & 0x000000ff000000ff) * 0x0000271000000001)) >> 32;
+    return true;
+}
+
+/*
+ * Read integer after optional sign, 0 when input does not start with
+ * number, the offending token is skipped then. Long runs of digits are
+ * taken 8 at a time.
+ */
+static int64_t in_int() {
+    in_skip_space();
+    auto neg = false;
+    auto c = in_peek();
+    if (c == '-' || c == '+') {
+        neg = c == '-';
+        ++in_pos;
+    }
+    auto digits = false;
+    uint64_t u = 0;
+    for (;;) {
+        uint64_t v;
+        if (in_end - in_pos >= 8 && eight_digits(in_pos, v)) {
+            u = u * 100000000 + v;
+            in_pos += 8;
+            digits = true;
+            continue;
+        }
+        c = in_peek();
+        if (c < '0' || c > '9')
+            break;
+        u = u * 10 + (c - '0');
+        ++in_pos;
+        digits = true;
+    }
+    if (!digits)
+        in_skip_token();
+    return neg ? 0 - u : u;
+}
+
+/*
+ * Characters of real number are collected and converted by strtod.
+ */
+static double in_real() {
+    in_skip_space();
+    char s[NUMBER_MAX * 2];
+    size_t n = 0;
+    for (auto c = in_peek(); n + 1 < sizeof(s) && c != -1
+            && ((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+'
+                || c == 'e' || c == 'E'); c = in_peek()) {
+        s[n++] = c;
+        ++in_pos;
+    }
+    s[n] = '\0';
+    if (n == 0)
+        in_skip_token();
+    return std::strtod(s, nullptr);
+}
+
+extern "C" int64_t sfe_scanln() {
+    return in_int();
+}
+
+extern "C" double sfe_scanln_real() {
+    return in_real();
+}
+
+extern "C" int64_t sfe_eof() {
+    in_skip_space();
+    return in_peek() == -1;
+}
+
+/*
+ * Store at most n numbers of input to a, stop at end of input. Returns
+ * number of stored elements.
+ */
+template <typename T, typename F>
+static int64_t read_array(T *a, int64_t n, F next) {
+    int64_t i = 0;
+    for (; i < n; ++i) {
+        in_skip_space();
+        if (in_peek() == -1)
+            break;
+        a[i] = static_cast<T>(next());
+    }
+    return i;
+}
+
+extern "C" int64_t sfe_readarray(void *a, int64_t len, int64_t n,
+        int64_t size) {
+    n = std::min(n, len);
+    switch (size) {
+        case 1:
+            return read_array(static_cast<uint8_t *>(a), n, in_int);
+        case 2:
+            return read_array(static_cast<uint16_t *>(a), n, in_int);
+        case 4:
+            return read_array(static_cast<uint32_t *>(a), n, in_int);
+        default:
+            return read_array(static_cast<int64_t *>(a), n, in_int);
+    }
+}
+
+extern "C" int64_t sfe_readarray_real(double *a, int64_t len, int64_t n) {
+    return read_array(a, std::min(n, len), in_real);
+}
+
+/* arguments of program, 0 is its source file */
+static int arg_count = 0;
+static char **arg_values = nullptr;
+
+extern "C" void sfe_args(int argc, char **argv) {
+    arg_count = argc;
+    arg_values = argv;
+}
+
+static const char *arg_file(int64_t k) {
+    if (k < 1 || k >= arg_count)
+        fail("missing file argument " + std::to_string(k));
+    return arg_values[k];
+}
+
+/*
+ * Whole pages of file replace pages of array in page aligned storage of
+ * its own, so nothing is parsed or copied. Other arrays, which may share
+ * pages with stack or other data, and the rest of file past the last whole
+ * page are read. Read only mapping makes writes to array fault, copy on
+ * write keeps them private. Returns number of bytes loaded.
+ */
+extern "C" int64_t sfe_map_array(void *a, int64_t bytes, int64_t k,
+        int64_t flags) {
+    auto name = arg_file(k);
+    auto fd = open(name, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+        fail(std::string{name} + ": " + std::strerror(errno));
+    auto n = std::min<int64_t>(bytes, st.st_size);
+    auto page = sysconf(_SC_PAGESIZE);
+    int64_t mapped = 0;
+    if ((flags & SFE_MAP_PAGES) != 0
+            && reinterpret_cast<uintptr_t>(a) % page == 0)
+        mapped = n / page * page;
+    if (mapped > 0) {
+        auto prot = PROT_READ | ((flags & SFE_MAP_WRITABLE) != 0
+                ? PROT_WRITE : 0);
+        if (mmap(a, mapped, prot, MAP_PRIVATE | MAP_FIXED, fd, 0)
+                == MAP_FAILED)
+            fail(std::string{name} + ": " + std::strerror(errno));
+        madvise(a, mapped, MADV_WILLNEED);
+    }
+    auto p = static_cast<char *>(a);
+    while (mapped < n) {
+        auto r = pread(fd, p + mapped, n - mapped, mapped);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            break;
+        mapped += r;
+    }
+    close(fd);
+    return mapped;
+}
+
+/*
+ * Write bytes of array to file, returns number of bytes written.
+ */
+extern "C" int64_t sfe_dump_array(const void *a, int64_t bytes, int64_t k) {
+    auto name = arg_file(k);
+    auto fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        fail(std::string{name} + ": " + std::strerror(errno));
+    auto p = static_cast<const char *>(a);
+    int64_t done = 0;
+    while (done < bytes) {
+        auto r = write(fd, p + done, bytes - done);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            break;
+        done += r;
+    }
+    close(fd);
+    return done;
+}
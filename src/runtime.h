@@ -0,0 +1,161 @@
+#ifndef runtime_h_q7f3lz0c2m9w8dxe
+#define runtime_h_q7f3lz0c2m9w8dxe
+
+#include <cstdint>
+
+/*
+ * Functions called from generated code. They are resolved by JIT in the
+ * compiler process, therefore they have C linkage.
+ */
+extern "C" {
+
+/* outlined body of parallel loop, runs iterations lo..hi */
+typedef void (*sfe_body)(void **, int64_t, int64_t);
+
+/* thunk of spawned call, reads arguments and result address from array */
+typedef void (*sfe_thunk)(int64_t *);
+
+/*
+ * sfe_par_for
+ * Split lo..hi into chunks and run them on worker threads.
+ */
+void sfe_par_for(sfe_body, void **, int64_t, int64_t);
+
+/*
+ * sfe_par_lock, sfe_par_unlock
+ * Guard merging of private reduction results into shared accumulators.
+ */
+void sfe_par_lock();
+void sfe_par_unlock();
+
+/*
+ * sfe_spawn
+ * Queue call of thunk with copy of n arguments and count it in group.
+ * Returns 0 when task was not queued and caller has to run it itself.
+ */
+int64_t sfe_spawn(sfe_thunk, const int64_t *, int64_t, int64_t *);
+
+/*
+ * sfe_sync
+ * Run queued tasks until all tasks counted in group are finished.
+ */
+void sfe_sync(int64_t *);
+
+/*
+ * sfe_alloc_array
+ * Allocate zeroed memory for large array, backed by transparent huge
+ * pages when second argument is not 0. Exits program when out of memory.
+ */
+void *sfe_alloc_array(int64_t, int64_t);
+
+/*
+ * sfe_free_array
+ * Release array of given size allocated by sfe_alloc_array.
+ */
+void sfe_free_array(void *, int64_t);
+
+/*
+ * sfe_hugepages
+ * Ask kernel to back static array by transparent huge pages.
+ */
+void sfe_hugepages(void *, int64_t);
+
+/*
+ * sfe_sum, sfe_max, sfe_min, sfe_count
+ * Aggregate n elements of array, count compares them with value.
+ */
+int64_t sfe_sum(const int64_t *, int64_t);
+int64_t sfe_max(const int64_t *, int64_t);
+int64_t sfe_min(const int64_t *, int64_t);
+int64_t sfe_count(const int64_t *, int64_t, int64_t);
+
+/*
+ * sfe_prefixsum
+ * Replace every element of array by sum of elements up to it.
+ */
+void sfe_prefixsum(int64_t *, int64_t);
+
+/*
+ * sfe_print, sfe_println, sfe_print_real, sfe_println_real
+ * Append number to output buffer, println variants end line.
+ */
+void sfe_print(int64_t);
+void sfe_println(int64_t);
+void sfe_print_real(double);
+void sfe_println_real(double);
+
+/*
+ * Item of write list is three words, kind, value and length. Scalar value
+ * is integer or bits of real, array value is address of its first element
+ * and length is number of elements. Size of array element in bytes is
+ * stored in kind above the flags.
+ */
+enum {
+    SFE_WRITE_REAL = 1,
+    SFE_WRITE_ARRAY = 2,
+    SFE_WRITE_UNSIGNED = 4,
+    SFE_WRITE_PACKED = 8,
+    SFE_WRITE_SIZE_SHIFT = 8
+};
+
+/*
+ * sfe_write
+ * Append n items separated by space to output buffer at once, optionally
+ * end line.
+ */
+void sfe_write(const int64_t *, int64_t, int64_t);
+
+/*
+ * sfe_flush
+ * Write buffered output, called at the end of program.
+ */
+void sfe_flush();
+
+/*
+ * sfe_scanln, sfe_scanln_real
+ * Read number from standard input, 0 at end of input.
+ */
+int64_t sfe_scanln();
+double sfe_scanln_real();
+
+/*
+ * sfe_eof
+ * Skip white space of input, return 1 when nothing else is left.
+ */
+int64_t sfe_eof();
+
+/*
+ * sfe_readarray, sfe_readarray_real
+ * Read at most n numbers of input into array of len elements, integer
+ * elements have given size in bytes. Return number of elements read.
+ */
+int64_t sfe_readarray(void *, int64_t, int64_t, int64_t);
+int64_t sfe_readarray_real(double *, int64_t, int64_t);
+
+/*
+ * sfe_args
+ * Remember arguments of program, the first one is its source file.
+ */
+void sfe_args(int, char **);
+
+/*
+ * Flags of sfe_map_array, copy on write instead of read only mapping, and
+ * array in page aligned storage of its own whose pages may be replaced.
+ */
+enum {
+    SFE_MAP_WRITABLE = 1,
+    SFE_MAP_PAGES = 2
+};
+
+/*
+ * sfe_map_array, sfe_dump_array
+ * Load array of given size in bytes from file named by k-th argument of
+ * program, read only or copy on write, or write array to it. Return
+ * number of bytes loaded or written.
+ */
+int64_t sfe_map_array(void *, int64_t, int64_t, int64_t);
+int64_t sfe_dump_array(const void *, int64_t, int64_t);
+
+}
+
+#endif /* runtime_h_q7f3lz0c2m9w8dxe */
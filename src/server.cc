@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "server.h"
+
+static bool socket_addr(const char *path, sockaddr_un &addr) {
+    std::memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof addr.sun_path)
+        return false;
+    std::strcpy(addr.sun_path, path);
+    return true;
+}
+
+static bool read_all(int fd, void *buf, size_t n) {
+    auto p = static_cast<char *>(buf);
+    while (n > 0) {
+        auto r = read(fd, p, n);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool write_all(int fd, const void *buf, size_t n) {
+    auto p = static_cast<const char *>(buf);
+    while (n > 0) {
+        auto r = write(fd, p, n);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+/*
+ * header of request is size of arguments, descriptors ride along with it
+ * as SCM_RIGHTS
+ */
+static bool send_header(int s, uint64_t size, const int *fds) {
+    char ctrl[CMSG_SPACE(sizeof(int) * REQUEST_FDS)];
+    std::memset(ctrl, 0, sizeof ctrl);
+    iovec iov{&size, sizeof size};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof ctrl;
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * REQUEST_FDS);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * REQUEST_FDS);
+    return sendmsg(s, &msg, 0) == sizeof size;
+}
+
+static bool recv_header(int s, uint64_t &size, int *fds) {
+    char ctrl[CMSG_SPACE(sizeof(int) * REQUEST_FDS)];
+    iovec iov{&size, sizeof size};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof ctrl;
+    if (recvmsg(s, &msg, MSG_CMSG_CLOEXEC) != sizeof size)
+        return false;
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET
+            || cmsg->cmsg_type != SCM_RIGHTS
+            || cmsg->cmsg_len != CMSG_LEN(sizeof(int) * REQUEST_FDS))
+        return false;
+    std::memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * REQUEST_FDS);
+    return true;
+}
+
+/* exit status of child, crash is 128 + signal like in shell */
+static int wait_status(pid_t pid) {
+    int w;
+    auto r = pid;
+    while (pid > 0 && (r = waitpid(pid, &w, 0)) < 0 && errno == EINTR)
+        ;
+    if (pid > 0 && r == pid && WIFEXITED(w))
+        return WEXITSTATUS(w);
+    if (pid > 0 && r == pid && WIFSIGNALED(w))
+        return 128 + WTERMSIG(w);
+    return EXIT_FAILURE;
+}
+
+/*
+ * handler runs in another child, so crash of compiler or program is
+ * reported to client as its status
+ */
+static int handle_request(int c, request_handler handler) {
+    uint64_t size;
+    int fds[REQUEST_FDS];
+    if (!recv_header(c, size, fds))
+        return EXIT_FAILURE;
+    std::string args(size, '\0');
+    if (size > 0 && !read_all(c, &args[0], size))
+        return EXIT_FAILURE;
+    std::vector<char *> argv{const_cast<char *>("llvm-sfe")};
+    for (size_t i = 0; i < size; i += std::strlen(&args[i]) + 1)
+        argv.push_back(&args[i]);
+    auto argc = static_cast<int>(argv.size());
+    argv.push_back(nullptr);
+
+    auto pid = fork();
+    if (pid == 0) {
+        close(c);
+        if (fchdir(fds[0]) != 0 || dup2(fds[1], STDIN_FILENO) < 0
+                || dup2(fds[2], STDOUT_FILENO) < 0
+                || dup2(fds[3], STDERR_FILENO) < 0)
+            _exit(EXIT_FAILURE);
+        for (auto fd : fds)
+            close(fd);
+        auto status = handler(argc, argv.data());
+        std::cout.flush();
+        std::exit(status);
+    }
+    for (auto fd : fds)
+        close(fd);
+    int32_t status = wait_status(pid);
+    write_all(c, &status, sizeof status);
+    return EXIT_SUCCESS;
+}
+
+int run_forked(request_handler handler, int argc, char **argv) {
+    std::cout.flush();
+    auto pid = fork();
+    if (pid == 0) {
+        auto status = handler(argc, argv);
+        std::cout.flush();
+        std::exit(status);
+    }
+    return wait_status(pid);
+}
+
+int serve(const char *path, request_handler handler) {
+    sockaddr_un addr;
+    auto s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s < 0 || !socket_addr(path, addr)) {
+        std::cout << "server error" << std::endl;
+        return EXIT_FAILURE;
+    }
+    /* only socket left by previous server is replaced */
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            std::cout << "server error: " << path << " is not socket"
+                << std::endl;
+            return EXIT_FAILURE;
+        }
+        unlink(path);
+    }
+    if (bind(s, reinterpret_cast<sockaddr *>(&addr), sizeof addr) != 0
+            || listen(s, SOMAXCONN) != 0) {
+        std::perror(path);
+        return EXIT_FAILURE;
+    }
+    /* children of server are reaped by kernel */
+    std::signal(SIGCHLD, SIG_IGN);
+    std::cout.flush();
+    for (;;) {
+        auto c = accept4(s, nullptr, nullptr, SOCK_CLOEXEC);
+        if (c < 0 && (errno == EINTR || errno == ECONNABORTED))
+            continue;
+        if (c < 0) {
+            std::perror(path);
+            return EXIT_FAILURE;
+        }
+        if (fork() == 0) {
+            close(s);
+            std::signal(SIGCHLD, SIG_DFL);
+            _exit(handle_request(c, handler));
+        }
+        close(c);
+    }
+}
+
+struct batch_job {
+    std::string file;
+    std::FILE *out;
+    std::chrono::steady_clock::time_point start;
+};
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * output of each compilation goes to temporary file and is printed after
+ * its status line, so outputs of parallel compilations do not mix
+ */
+static void batch_result(const batch_job &job, int w) {
+    auto ok = WIFEXITED(w) && WEXITSTATUS(w) == EXIT_SUCCESS;
+    std::cout << job.file << ": " << (ok ? "ok" : "failed");
+    if (WIFEXITED(w) && !ok)
+        std::cout << " " << WEXITSTATUS(w);
+    else if (WIFSIGNALED(w))
+        std::cout << " " << 128 + WTERMSIG(w);
+    std::cout << " " << elapsed_ms(job.start) << " ms" << std::endl;
+    char buf[4096];
+    std::rewind(job.out);
+    for (size_t n; (n = std::fread(buf, 1, sizeof buf, job.out)) > 0; )
+        std::cout.write(buf, n);
+    std::fclose(job.out);
+}
+
+int batch(int argc, char **argv, request_handler handler) {
+    std::vector<char *> opts{const_cast<char *>("llvm-sfe"),
+        const_cast<char *>("-c")};
+    std::vector<std::string> files;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    for (auto i = 0; i < argc; ++i) {
+        auto arg = std::string(argv[i]);
+        if (arg.size() > 2 && arg.compare(0, 2, "-j") == 0)
+            jobs = std::atol(arg.c_str() + 2);
+        else if (arg[0] == '-')
+            opts.push_back(argv[i]);
+        else if (arg[0] == '@') {
+            std::ifstream manifest{arg.substr(1)};
+            if (!manifest) {
+                std::perror(arg.c_str() + 1);
+                return EXIT_FAILURE;
+            }
+            for (std::string line; std::getline(manifest, line); )
+                if (!line.empty())
+                    files.push_back(line);
+        } else
+            files.push_back(arg);
+    }
+    jobs = std::max(jobs, 1l);
+
+    std::cout << std::fixed << std::setprecision(1);
+    auto start = std::chrono::steady_clock::now();
+    std::map<pid_t, batch_job> running;
+    size_t next = 0;
+    auto failed = 0;
+    while (next < files.size() || !running.empty()) {
+        if (next < files.size() && static_cast<long>(running.size()) < jobs) {
+            auto &file = files[next++];
+            auto out = std::tmpfile();
+            std::cout.flush();
+            auto pid = out == nullptr ? -1 : fork();
+            if (pid == 0) {
+                if (dup2(fileno(out), STDOUT_FILENO) < 0
+                        || dup2(fileno(out), STDERR_FILENO) < 0)
+                    _exit(EXIT_FAILURE);
+                auto argv = opts;
+                argv.push_back(&file[0]);
+                auto argc = static_cast<int>(argv.size());
+                argv.push_back(nullptr);
+                auto status = handler(argc, argv.data());
+                std::cout.flush();
+                std::exit(status);
+            }
+            if (pid < 0) {
+                std::perror(file.c_str());
+                if (out != nullptr)
+                    std::fclose(out);
+                ++failed;
+                continue;
+            }
+            running[pid] = batch_job{file, out,
+                std::chrono::steady_clock::now()};
+            continue;
+        }
+        int w;
+        auto pid = waitpid(-1, &w, 0);
+        if (pid < 0 && errno == EINTR)
+            continue;
+        if (pid < 0)
+            break;
+        auto job = running.find(pid);
+        if (job == running.end())
+            continue;
+        if (!WIFEXITED(w) || WEXITSTATUS(w) != EXIT_SUCCESS)
+            ++failed;
+        batch_result(job->second, w);
+        running.erase(job);
+    }
+    std::cout << files.size() << " files, " << failed << " failed, "
+        << elapsed_ms(start) << " ms" << std::endl;
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int request(const char *path, int argc, char **argv) {
+    sockaddr_un addr;
+    auto s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s < 0 || !socket_addr(path, addr)
+            || connect(s, reinterpret_cast<sockaddr *>(&addr),
+                sizeof addr) != 0) {
+        std::perror(path);
+        return EXIT_FAILURE;
+    }
+    std::string args;
+    for (auto i = 0; i < argc; ++i) {
+        args += argv[i];
+        args += '\0';
+    }
+    int fds[REQUEST_FDS] = {open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC),
+        STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    int32_t status;
+    if (fds[0] < 0 || !send_header(s, args.size(), fds)
+            || !write_all(s, args.data(), args.size())
+            || !read_all(s, &status, sizeof status)) {
+        std::cout << "request error" << std::endl;
+        return EXIT_FAILURE;
+    }
+    close(fds[0]);
+    close(s);
+    return status;
+}
@@ -0,0 +1,49 @@
+#ifndef server_h_v5n1e8kq3rbx0yth
+#define server_h_v5n1e8kq3rbx0yth
+
+/*
+ * Compile server keeps initialized LLVM in one process and compiles on
+ * request of clients over Unix socket. Request carries arguments of
+ * llvm-sfe and descriptors of working directory, stdin, stdout and
+ * stderr of client, reply is exit status. Batch mode compiles many files
+ * in processes forked the same way.
+ */
+
+/* working directory, stdin, stdout and stderr */
+const int REQUEST_FDS = 4;
+
+/* handler of request, gets argv of llvm-sfe and returns exit status */
+typedef int (*request_handler)(int, char **);
+
+/*
+ * serve
+ * Listen on socket path and run handler for each request in process
+ * forked from server, so it inherits initialized LLVM and its state is
+ * dropped afterwards. Returns only when socket cannot be used.
+ */
+int serve(const char *, request_handler);
+
+/*
+ * run_forked
+ * Run handler with arguments in forked process and return its status.
+ */
+int run_forked(request_handler, int, char **);
+
+/*
+ * batch
+ * Compile files given among arguments, or listed one per line in file
+ * given as @manifest, in up to -jN forked processes at once, other
+ * arguments are options passed to each compilation. Prints status and
+ * time of each file with its compiler output, returns failure when any
+ * file failed.
+ */
+int batch(int, char **, request_handler);
+
+/*
+ * request
+ * Send arguments to server listening on socket path, program runs with
+ * stdin and stdout of caller. Returns exit status of compiler or program.
+ */
+int request(const char *, int, char **);
+
+#endif